@@ -0,0 +1,412 @@
+/*------------------------------------------------------------
+ * vfbench.cc
+ * Benchmarks of the library, run as
+ *     vfbench text|load|compat [nodes]
+ *
+ * text   times the construction of a StreamARGLoader reading
+ *        a synthetic text graph with int attributes, and one
+ *        with double attributes, and prints the throughput
+ *        in MB/s. The files are written in the current
+ *        directory, and removed at the end.
+ *
+ * load   times the construction of a Graph from a loader
+ *        giving random edges, without attributes (so that
+ *        the time is mostly spent building the edge vectors,
+ *        'in' vectors included); by default for several sizes,
+ *        the largest one (with more than PARALLEL_BUILD_EDGES
+ *        edges) only if compiled with -DVF_LARGE_GRAPHS.
+ *
+ * compat compares the states using the comparators of the
+ * graphs (VF2State, VF2SubState, VF2MonoState) with the ones
+ * using compile-time comparators (see vf2_compat_state.h),
+ * on pairs of random graphs made by Generate, with int node
+ * and edge labels; a subgraph of the second graph is used
+ * for subgraph isomorphism and monomorphism.
+ *
+ * Each measure is the best of a few runs.
+ -----------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <fstream>
+
+#include "argraph.h"
+#include "argloader.h"
+#include "allocpool.h"
+#include "gene.h"
+#include "xsubgraph.h"
+#include "match.h"
+#include "vf2_state.h"
+#include "vf2_sub_state.h"
+#include "vf2_mono_state.h"
+#include "vf2_compat_state.h"
+#include "error.h"
+
+
+/* Each measure is the best of this number of runs */
+static const int runs=3;
+
+/* Out degree of the nodes of the synthetic graphs */
+static const int text_degree=10;
+static const int load_degree=8;
+
+/* Parameters of the compat benchmark: number of graph pairs,
+ * edges per node, labels, and size of the subgraph */
+static const int compat_pairs=20;
+static const int compat_degree=3;
+static const int compat_labels=4;
+static const int compat_sub_ratio=20;
+
+
+/*------------------------------------------------------------
+ * class RandomLoader
+ * A loader giving a graph of n nodes with d random out edges
+ * each, sorted by destination, and no attributes
+ -----------------------------------------------------------*/
+class RandomLoader: public ARGLoader
+  { private:
+      int n, d;
+      node_id *dest;
+
+    public:
+      RandomLoader(int n, int d);
+      ~RandomLoader() { delete[] dest; }
+
+      virtual int NodeCount() { return n; }
+      virtual void *GetNodeAttr(node_id) { return NULL; }
+      virtual int OutEdgeCount(node_id) { return d; }
+      virtual node_id GetOutEdge(node_id node, int i, void **pattr)
+        { if (pattr!=NULL)
+            *pattr=NULL;
+          return dest[(size_t)node*d+i];
+        }
+  };
+
+static double now();
+static void write_text_graph(const char *name, int n, bool doubles);
+static double file_size(const char *name);
+template <class Node, class Edge>
+static double time_text_load(const char *name);
+static void bench_text(int n);
+static void bench_load(int n);
+static int *label_graph(Graph *g, int *node_label);
+static bool int_compat(void *attr1, void *attr2);
+static bool count_visitor(int n, node_id c1[], node_id c2[], void *usr);
+template <class S>
+static double time_match(Graph *g1, Graph *g2, long *pcount);
+static void bench_compat(int n);
+
+
+/*------------------------------------------------------------
+ * Runs the benchmark given on the command line
+ -----------------------------------------------------------*/
+int main(int argc, char *argv[])
+  { if (argc<2 || argc>3)
+      { fprintf(stderr, "Usage: %s text|load|compat [nodes]\n", argv[0]);
+        return 1;
+      }
+    int n=(argc>2)? atoi(argv[2]): 0;
+    if (n<0 || (node_id)n>=NULL_NODE)
+      error("vfbench: bad number of nodes: %s", argv[2]);
+
+    if (strcmp(argv[1], "text")==0)
+      bench_text(n>0? n: 60000);
+    else if (strcmp(argv[1], "load")==0)
+      { if (n>0)
+          bench_load(n);
+        else
+          { bench_load(20000);
+            bench_load(50000);
+            if (NULL_NODE>200000)    // -DVF_LARGE_GRAPHS
+              bench_load(200000);
+          }
+      }
+    else if (strcmp(argv[1], "compat")==0)
+      bench_compat(n>0? n: 400);
+    else
+      error("vfbench: unknown benchmark: %s", argv[1]);
+    return 0;
+  }
+
+
+/*------------------------------------------------------------
+ * Wall clock time in seconds
+ -----------------------------------------------------------*/
+static double now()
+  { using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+  }
+
+
+/*------------------------------------------------------------
+ * Writes a text graph of n nodes, each with text_degree out
+ * edges, in the format read by StreamARGLoader. The
+ * attributes are ints, or doubles if doubles is true.
+ * Comments and blank lines are interspersed, as in the dumps
+ * written by hand.
+ -----------------------------------------------------------*/
+static void write_text_graph(const char *name, int n, bool doubles)
+  { FILE *f=fopen(name, "w");
+    if (f==NULL)
+      error("vfbench: cannot write %s", name);
+
+    int i, j;
+    srand(1);
+    fprintf(f, "# %d nodes\n%d\n", n, n);
+    for(i=0; i<n; i++)
+      if (doubles)
+        fprintf(f, "%d %g\n", i, rand()/3.0);
+      else
+        fprintf(f, "%d %d\n", i, rand()%1000);
+
+    int step=n/text_degree;
+    for(i=0; i<n; i++)
+      { fprintf(f, "\n# edges of node %d\n%d\n", i, text_degree);
+        for(j=0; j<text_degree; j++)
+          { int other=(i+j*step+rand()%(step>0? step: 1))%n;
+            if (doubles)
+              fprintf(f, "%d %d %.3f\n", i, other, rand()/5.0);
+            else
+              fprintf(f, "%d %d %d\n", i, other, rand()%100-50);
+          }
+      }
+    if (fclose(f)!=0)
+      error("vfbench: cannot write %s", name);
+  }
+
+/*------------------------------------------------------------
+ * Size of a file in MB
+ -----------------------------------------------------------*/
+static double file_size(const char *name)
+  { ifstream in(name, ios::binary|ios::ate);
+    if (!in)
+      error("vfbench: cannot read %s", name);
+    return (double)in.tellg()/1e6;
+  }
+
+/*------------------------------------------------------------
+ * Best time of the construction of a StreamARGLoader reading
+ * the given file
+ -----------------------------------------------------------*/
+template <class Node, class Edge>
+static double time_text_load(const char *name)
+  { double best=0;
+    int r;
+    for(r=0; r<runs; r++)
+      { AllocationPool<Node, 1024> nalloc;
+        AllocationPool<Edge, 1024> ealloc;
+        ifstream in(name);
+        if (!in)
+          error("vfbench: cannot read %s", name);
+
+        double t0=now();
+        StreamARGLoader<Node, Edge> loader(&nalloc, &ealloc, in);
+        double t=now()-t0;
+
+        if (loader.NodeCount()==0)
+          error("vfbench: %s has no nodes", name);
+        if (r==0 || t<best)
+          best=t;
+      }
+    return best;
+  }
+
+/*------------------------------------------------------------
+ * The text benchmark: loads a graph of n nodes with int and
+ * double attributes
+ -----------------------------------------------------------*/
+static void bench_text(int n)
+  { static const char *int_name="vfbench-int.txt";
+    static const char *double_name="vfbench-double.txt";
+
+    write_text_graph(int_name, n, false);
+    write_text_graph(double_name, n, true);
+
+    double mb=file_size(int_name);
+    double t=time_text_load<int, int>(int_name);
+    printf("text int:    %6.1f MB  %7.3f s  %7.1f MB/s\n", mb, t, mb/t);
+
+    mb=file_size(double_name);
+    t=time_text_load<double, double>(double_name);
+    printf("text double: %6.1f MB  %7.3f s  %7.1f MB/s\n", mb, t, mb/t);
+
+    remove(int_name);
+    remove(double_name);
+  }
+
+
+/*------------------------------------------------------------
+ * Makes the edges of the random graph: the i-th edge of a
+ * node goes to a random node in the i-th of d ranges
+ * following it, so there are no duplicates
+ -----------------------------------------------------------*/
+RandomLoader::RandomLoader(int n, int d)
+  { if (n<d)
+      d=n;
+    this->n=n;
+    this->d=d;
+    dest=new node_id[(size_t)n*d];
+    if (dest==NULL)
+      OUT_OF_MEMORY();
+
+    int i, j, k;
+    int step=n/d;
+    srand(1);
+    for(i=0; i<n; i++)
+      { node_id *p=dest+(size_t)i*d;
+        for(j=0; j<d; j++)
+          { node_id id=(node_id)((i+(long)j*step+rand()%step)%n);
+            for(k=j; k>0 && p[k-1]>id; k--)
+              p[k]=p[k-1];
+            p[k]=id;
+          }
+      }
+  }
+
+/*------------------------------------------------------------
+ * The load benchmark: builds a graph of n nodes from a
+ * RandomLoader
+ -----------------------------------------------------------*/
+static void bench_load(int n)
+  { RandomLoader loader(n, load_degree);
+    double best=0;
+    long edges=0;
+    int r;
+    for(r=0; r<runs; r++)
+      { double t0=now();
+        Graph *g=new Graph(&loader);
+        double t=now()-t0;
+
+        int i;
+        edges=0;
+        for(i=0; i<n; i++)
+          edges+=g->OutEdgeCount(i);
+        delete g;
+        if (r==0 || t<best)
+          best=t;
+      }
+    printf("load: %7d nodes  %8ld edges  %7.3f s\n", n, edges, best);
+  }
+
+
+/*------------------------------------------------------------
+ * Labels the nodes and the edges of a graph by their degrees,
+ * so that two isomorphic graphs get corresponding labels.
+ * The node labels are stored in the given vector, the edge
+ * labels in a new one, which is returned; both must outlive
+ * the graph.
+ -----------------------------------------------------------*/
+static int *label_graph(Graph *g, int *node_label)
+  { int i, j, k=0;
+    int n=g->NodeCount();
+    int edges=0;
+    for(i=0; i<n; i++)
+      edges+=g->OutEdgeCount(i);
+    int *edge_label=new int[edges];
+    if (edge_label==NULL)
+      OUT_OF_MEMORY();
+
+    for(i=0; i<n; i++)
+      { node_label[i]=(3*g->InEdgeCount(i)+g->OutEdgeCount(i))%compat_labels;
+        g->SetNodeAttr(i, &node_label[i]);
+      }
+    for(i=0; i<n; i++)
+      for(j=0; j<g->OutEdgeCount(i); j++)
+        { node_id other=g->GetOutEdge(i, j);
+          edge_label[k]=(node_label[i]+2*node_label[other])%compat_labels;
+          g->SetEdgeAttr(i, other, &edge_label[k++]);
+        }
+    return edge_label;
+  }
+
+/*------------------------------------------------------------
+ * The comparator of the int labels, set in the graphs
+ -----------------------------------------------------------*/
+static bool int_compat(void *attr1, void *attr2)
+  { return *(int *)attr1 == *(int *)attr2;
+  }
+
+/*------------------------------------------------------------
+ * A visitor which only lets match count the matches
+ -----------------------------------------------------------*/
+static bool count_visitor(int, node_id [], node_id [], void *)
+  { return false;
+  }
+
+/*------------------------------------------------------------
+ * Time of the search for all the matches between g1 and g2
+ * using the state class S; the matches are added to *pcount
+ -----------------------------------------------------------*/
+template <class S>
+static double time_match(Graph *g1, Graph *g2, long *pcount)
+  { double t0=now();
+    S s0(g1, g2);
+    *pcount+=match(&s0, count_visitor);
+    return now()-t0;
+  }
+
+/*------------------------------------------------------------
+ * The compat benchmark: compat_pairs pairs of graphs of n
+ * nodes
+ -----------------------------------------------------------*/
+static void bench_compat(int n)
+  { typedef EqualAttrCompat<int> IntCompat;
+    enum { ISO, SUB, MONO, KINDS };
+    static const char *name[KINDS]={ "iso", "sub", "mono" };
+    double t[KINDS][2];
+    long count[KINDS][2];
+    int p, k;
+
+    for(k=0; k<KINDS; k++)
+      { t[k][0]=t[k][1]=0;
+        count[k][0]=count[k][1]=0;
+      }
+
+    int *node_label1=new int[n];
+    int *node_label2=new int[n];
+    if (node_label1==NULL || node_label2==NULL)
+      OUT_OF_MEMORY();
+
+    srand(99);
+    for(p=0; p<compat_pairs; p++)
+      { Graph *g1, *g2;
+        Generate(n, n*compat_degree, &g1, &g2, true);
+        int *edge_label1=label_graph(g1, node_label1);
+        int *edge_label2=label_graph(g2, node_label2);
+        Graph *sub=ExtractSubgraph(g2, n/compat_sub_ratio, true);
+        g1->SetNodeCompat(int_compat);
+        g1->SetEdgeCompat(int_compat);
+        sub->SetNodeCompat(int_compat);
+        sub->SetEdgeCompat(int_compat);
+
+        t[ISO][0]+=time_match<VF2State>(g1, g2, &count[ISO][0]);
+        t[ISO][1]+=time_match<VF2CompatState<IntCompat> >(g1, g2,
+                                                   &count[ISO][1]);
+        t[SUB][0]+=time_match<VF2SubState>(sub, g2, &count[SUB][0]);
+        t[SUB][1]+=time_match<VF2SubCompatState<IntCompat> >(sub, g2,
+                                                   &count[SUB][1]);
+        t[MONO][0]+=time_match<VF2MonoState>(sub, g2, &count[MONO][0]);
+        t[MONO][1]+=time_match<VF2MonoCompatState<IntCompat> >(sub, g2,
+                                                   &count[MONO][1]);
+
+        delete sub;
+        delete g1;
+        delete g2;
+        delete[] edge_label1;
+        delete[] edge_label2;
+      }
+
+    for(k=0; k<KINDS; k++)
+      { if (count[k][0]!=count[k][1])
+          error("vfbench: the %s states found %ld and %ld matches",
+                name[k], count[k][0], count[k][1]);
+        printf("compat %-4s  %8ld matches  comparators %7.3f s  "
+               "templates %7.3f s\n", name[k], count[k][0],
+               t[k][0], t[k][1]);
+      }
+
+    delete[] node_label1;
+    delete[] node_label2;
+  }
@@ -33,6 +33,28 @@
  *       deallocation of the attributes, which must be
  *       dealt with by the programmer.
  -------------------------------------------------------*/
+
+/*---------------------------------------------------------
+ *   IMPLEMENTATION NOTES
+ *
+ * The nodes and the edges are kept in growable vectors;
+ * InsertNode and InsertEdge just append to them, in constant
+ * (amortized) time, whatever the order of the edges.
+ * The edges are sorted by source and destination (and an
+ * index of the first edge of each node is built) only when
+ * they are needed, i.e. when GetOutEdge or DeleteEdge is
+ * called after some edges have been inserted or a node has
+ * been deleted. The sorting is a two pass counting sort,
+ * taking O(n+E) time, and is skipped when the edges have been
+ * inserted already sorted. Inserting an edge twice is an
+ * error, detected when the edges are sorted.
+ * So a graph is built in linear time, as long as all the
+ * edges are inserted before the edges are read.
+ * DeleteEdge takes O(log d) time to find the edge (d being
+ * the number of edges of the node) plus O(d) to close the
+ * gap; DeleteNode takes O(n+E), since the following nodes
+ * have to be renumbered.
+ -------------------------------------------------------*/
 class ARGEdit: public ARGLoader
   { 
     public:
@@ -47,6 +69,7 @@ class ARGEdit: public ARGLoader
       virtual void *GetNodeAttr(node_id node);
       virtual int OutEdgeCount(node_id node);
       virtual node_id GetOutEdge(node_id node, int i, void **pattr);
+      virtual void GetOutEdges(node_id node, node_id *dest, void **attrs);
 
       /* Graph edit operations */
       node_id InsertNode(void *attr);
@@ -54,28 +77,35 @@ class ARGEdit: public ARGLoader
       void DeleteNode(node_id n);
       void DeleteEdge(node_id n1, node_id n2);
 
-    protected:
-      int count;
+      size_t MemoryUsage();
+      static size_t EstimateMemoryUsage(int nodes, size_t edges);
 
+    protected:
       struct eNode
-        { node_id from;
+        { node_id from;     /* NULL_NODE for a deleted edge */
           node_id to;
-          int pos;
           void *attr;
-          eNode *next;
         };
 
-      struct nNode 
-        { node_id id;
-          int count;
-          void *attr;
-          nNode *next;
-          eNode *edges;
-        };
+      int count;            /* number of nodes */
+      int node_cap;         /* size of the node vectors */
+      void* *node_attr;     /* attribute of each node */
+      int *out_count;       /* number of edges of each node */
+      size_t *first;        /* position of the first edge of each
+                               node, valid if sorted is true */
+
+      eNode *edges;         /* the edges, sorted if sorted is true;
+                               in that case, the edges of node i
+                               are from first[i] to 
+                               first[i]+out_count[i]-1 */
+      size_t edge_count;    /* used elements of edges (including
+                               the deleted ones) */
+      size_t edge_cap;      /* size of edges */
+      bool sorted;
 
-      nNode *nodes;
-      nNode *lastNode;
-      eNode *lastEdge;
+      void Init();
+      void Reserve(int nodes, size_t edges);
+      void Sort();
 
       virtual void destroyNodeAttr(void *) {};
       virtual void destroyEdgeAttr(void *) {};
@@ -59,13 +59,15 @@
  *     02 00     Target of the second edge of node 1 (edge 1 -> 2)
  *     01 00     Number of edges out of node 2 (1)
  *     00 00     Target of the first (and only) edge of node 2 (edge 2 -> 0)
+ * Since the words are 16 bits wide, graphs with more than 65535 nodes
+ * (allowed when the library is compiled with VF_LARGE_GRAPHS) cannot
+ * be stored in this format.
  ---------------------------------------------------------------------------*/
 
 #ifndef ARGLOADER_H
 #define ARGLOADER_H
 
 #include <iostream>
-#include <strstream>
 #include <ctype.h>
 
 
@@ -73,8 +75,7 @@
 // if the following line cause errors, your compiler
 // does not recognize C++ namespaces. Just comment it out.
 // You will probably also have to replace <iostream> with <iostream.h>
-// and <strstream> with <strstream.h> (or maybe <strstrea.h>) in the
-// above #include directives.
+// in the above #include directives.
 //
 using namespace std;
 
@@ -83,6 +84,59 @@ using namespace std;
 #include "argedit.h"
 #include "allocpool.h"
 
+
+/*------------------------------------------------------------
+ * class TextReader
+ * Reads a text file one line at a time, skipping blank lines
+ * and comments, and splits the current line into fields.
+ * The lines are read into a buffer which is reused (and
+ * enlarged only for a line longer than all the previous ones),
+ * and the numbers are converted without going thru the
+ * stream operators. The stream is never read past the end
+ * of the last line requested, so that what follows can be
+ * read by someone else.
+ * The fields of other types are read using their operator>>,
+ * applied to a stream which reads the rest of the current
+ * line directly from the buffer.
+ -----------------------------------------------------------*/
+class TextReader
+  { private:
+      class LineBuf: public streambuf
+        { public:
+            void Set(char *begin, char *end) { setg(begin, begin, end); }
+            char *Position() { return gptr(); }
+        };
+
+      istream &in;
+      char *line;        /* the current line */
+      size_t size;       /* size of the line buffer */
+      char *pos;         /* the next field of the current line */
+      char *line_end;
+      LineBuf buf;
+      istream field_in;  /* reads the current line from buf */
+
+      bool ReadLong(long &value);
+      bool ReadUnsigned(unsigned long &value);
+
+    public:
+      TextReader(istream &in);
+      ~TextReader();
+
+      bool GetLine();
+      void NextLine();
+      char *Line() { return line; }
+
+      bool Read(int &value);
+      bool Read(long &value);
+      bool Read(short &value);
+      bool Read(unsigned &value);
+      bool Read(unsigned long &value);
+      bool Read(unsigned short &value);
+      bool Read(double &value);
+      bool Read(float &value);
+      template <class T> bool Read(T &value);
+  };
+
 template <class Node, class Edge>
 class StreamARGLoader: public ARGEdit
   { 
@@ -98,11 +152,9 @@ class StreamARGLoader: public ARGEdit
 
     private:
 
-      enum { MAX_LINE=512 };
-      void readLine(istream &in, char *line);
-      int  readCount(istream &in);
-      void readNode(NodeAllocator *alloc, istream &in);
-      void readEdge(EdgeAllocator *alloc, istream &in);
+      int  readCount(TextReader &in);
+      void readNode(NodeAllocator *alloc, TextReader &in);
+      void readEdge(EdgeAllocator *alloc, TextReader &in);
   };
 
 
@@ -118,6 +170,23 @@ class BinaryGraphLoader: public ARGEdit
   };
 
 
+/*------------------------------------------------------------
+ * Methods of the class TextReader
+ -----------------------------------------------------------*/
+
+/*----------------------------------------------------------
+ * Reads a field of a generic type, using its operator>>
+ ---------------------------------------------------------*/
+template <class T>
+bool TextReader::Read(T &value)
+  { buf.Set(pos, line_end);
+    field_in.clear();
+    field_in >> value;
+    pos=buf.Position();
+    return !field_in.fail();
+  }
+
+
 /*------------------------------------------------------------
  * Methods of the class StreamArgLoader
  -----------------------------------------------------------*/
@@ -130,8 +199,9 @@ StreamARGLoader<Node, Edge>::
 StreamARGLoader(Allocator<Node> *nalloc, 
                 Allocator<Edge> *ealloc, 
                 istream &in)
-  { 
-    int cnt=readCount(in);
+  { TextReader reader(in);
+
+    int cnt=readCount(reader);
     if (cnt<=0)
       { cnt=0;
         return;
@@ -139,48 +209,29 @@ StreamARGLoader(Allocator<Node> *nalloc,
 
     int i;
     for(i=0; i<cnt; i++)
-      { readNode(nalloc, in);
+      { readNode(nalloc, reader);
       }
 
     for(i=0; i<cnt; i++)
       { int ecount, j;
-        ecount=readCount(in);
+        ecount=readCount(reader);
         for(j=0; j<ecount; j++)
-          readEdge(ealloc, in);
+          readEdge(ealloc, reader);
       }
         
   }
 
-/*------------------------------------------------------
- * Reads a line from the input stream
- ----------------------------------------------------*/
-template <class Node, class Edge>
-void StreamARGLoader<Node, Edge>::
-readLine(istream &in, char *line)
-  { 
-    char *p;
-    do {
-      *line='\0';
-      if (!in.good())
-        error("End of file or reading error");
-      in.getline(line, MAX_LINE);
-      for(p=line; isspace(*p); p++)
-        ;
-    } while (*p=='\0' || *p=='#');
-  }
-
 /*------------------------------------------------------
  * Reads an int from a line
  ----------------------------------------------------*/
 template <class Node, class Edge>
 int StreamARGLoader<Node, Edge>::
-readCount(istream &in)
-  { char line[MAX_LINE+1];
-    readLine(in, line);
+readCount(TextReader &in)
+  { in.NextLine();
     
     int i;
-    istrstream is(line);
-    is>>i;
+    if (!in.Read(i))
+      error("File format error\n  Line: %s", in.Line());
 
     return i;
   }
@@ -190,18 +241,17 @@ readCount(istream &in)
  ----------------------------------------------------*/
 template <class Node, class Edge>
 void StreamARGLoader<Node, Edge>::
-readNode(Allocator<Node> *alloc, istream &in)
-  { char line[MAX_LINE+1];
-    readLine(in, line);
-    istrstream is(line);
+readNode(Allocator<Node> *alloc, TextReader &in)
+  { in.NextLine();
     
     Node *nattr=alloc->Allocate();
     node_id id;
 
-    is >> id >> *nattr;
+    if (!in.Read(id) || (nattr!=NULL && !in.Read(*nattr)))
+      error("File format error\n  Line: %s", in.Line());
 
-    if (id != NodeCount())
-      error("File format error\n  Line: %s", line);
+    if (id != (node_id)NodeCount())
+      error("File format error\n  Line: %s", in.Line());
 
     InsertNode(nattr);
   }
@@ -211,15 +261,15 @@ readNode(Allocator<Node> *alloc, istream &in)
  ----------------------------------------------------*/
 template <class Node, class Edge>
 void StreamARGLoader<Node, Edge>::
-readEdge(Allocator<Edge> *alloc, istream &in)
-  { char line[MAX_LINE+1];
-    readLine(in, line);
-    istrstream is(line);
+readEdge(Allocator<Edge> *alloc, TextReader &in)
+  { in.NextLine();
     
     Edge *eattr=alloc->Allocate();
     node_id id1, id2;
 
-    is >> id1 >> id2 >> *eattr;
+    if (!in.Read(id1) || !in.Read(id2) || 
+        (eattr!=NULL && !in.Read(*eattr)))
+      error("File format error\n  Line: %s", in.Line());
 
     InsertEdge(id1, id2, eattr);
   }
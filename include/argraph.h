@@ -16,7 +16,7 @@
  * the real work and represents the node and edge attributes
  * using void* pointers; 
  * A template-based interface class ARGraph<NodeType,EdgeType>
- * provides type checking. Attributes are always managed 
+ * provides type checking. Attributes are always passed 
  * via pointers. 
  *
  * The user has two choices for the attribute allocation strategy:
@@ -25,16 +25,42 @@
  * are owned by the graph, and are deallocated by means of a
  * user provided object or function.
  *
+ * Alternatively, attributes of a fixed size can be stored by
+ * value inside the graph (ATTR_BY_VALUE): the attribute provided
+ * by the loader is copied (using memcpy) into a vector holding
+ * the attributes of all the nodes (or edges), and the pointers
+ * returned by the graph point into that vector. In this way the
+ * attributes returned by the loader are no longer needed once
+ * the graph has been built, and no pointer has to be followed
+ * to reach an attribute. Only types that can be copied with 
+ * memcpy (e.g. ints or simple structs) can be stored by value;
+ * attributes stored by value are never passed to the destroy
+ * functions.
+ *
+ * When the attributes are just integer labels to be compared
+ * for equality, the graph can keep a copy of them as plain ints
+ * (see UseIntLabels). The matching states compare the nodes and
+ * edges using CompatibleNodes/CompatibleOutEdge/... which, if 
+ * both graphs have int labels, compare them inline instead of
+ * calling the (virtual) CompatibleNode/CompatibleEdge methods.
+ *
  * The graphs, once created, are immutable, in the sense that
  * graph-editing operations are not provided.
  * This allows the use of an internal representation particularly
  * suited for efficient graph matching, which is the primary target
- * of this program.
+ * of this program. The derived class DynamicGraph (see dyngraph.h)
+ * keeps the same representation, but allows edges and nodes to
+ * be added (and edges removed) in batches; the derived class
+ * MappedGraph (see mapgraph.h) maps the same vectors from a file.
  *
  * An abstract class, ARGLoader, is defined to allow the
  * use of different file formats for loading the graphs.
  * The loader is queried by the ARGraph to acquire the information
- * needed for building the graph.
+ * needed for building the graph. Besides the edge-by-edge
+ * GetOutEdge, a loader can redefine GetOutEdges, which copies
+ * all the edges of a node (and their attributes) at once, saving
+ * a virtual call per edge; the default version just calls
+ * GetOutEdge for each edge.
  * A simple ARGLoader based on iostream.h is provided in
  * argloader.h; see also argedit.h/argedit.cc for a class which can
  * be used as a base for a new ARGLoader.
@@ -42,13 +68,36 @@
 
 /*--------------------------------------------------------------------
  *   MORE IMPLEMENTATION DETAILS
- * Edges and edge attributes (pointers) are stored into sorted 
- * vectors associated to each node, and are looked for
- * using binary search. 
+ * Edges and edge attributes (pointers) are stored using a
+ * compressed sparse row layout: for each direction there is
+ * a single vector holding the edges of all the nodes, sorted by
+ * source node and then by destination, and a vector of offsets
+ * giving the position of the first edge of each node. The
+ * attributes are kept in vectors parallel to the edge vectors.
+ * The edges of a node end at the position given by the vectors
+ * out_end and in_end; in a graph built from a loader these just
+ * point one element past out_start and in_start, while a 
+ * DynamicGraph leaves some room after each list.
+ * Edges are looked for using a linear scan if the node has very
+ * few edges, using binary search otherwise. For hub nodes (the
+ * ones with at least HUB_DEGREE 'out' edges) a hash table is
+ * built together with the graph, so that the lookup time does not
+ * depend on the number of edges.
+ * All the vectors of a graph are carved from a single heap block,
+ * so building or destroying a graph requires only one allocation.
  * 
  * Nodes are identified using the type node_id, which is currently
  * unsigned short; the special value NULL_NODE is used as null
  * value for this type.
+ * If the macro VF_LARGE_GRAPHS is defined during compilation,
+ * node_id becomes a 32-bit unsigned int, allowing graphs with
+ * more than 65535 nodes (and nodes with more than 65535 edges).
+ * The macro must be defined in the same way
+ * for the library and for the programs using it, since it changes
+ * the layout of the classes. The default (16-bit) node_id should
+ * be preferred for small graphs, since it halves the memory used
+ * by the node ids and by the state vectors of the matching
+ * algorithms.
  *
  * Bound checks are performed using the assert macro. They can be
  * disabled by ensuring the macro NDEBUG is defined during 
@@ -57,6 +106,48 @@
  * NOTE: Differently from the previous versions  of this library 
  * (before version 2.0), there is no more an adjacency matrix to 
  * check for the existence of a node.
+ * However, an adjacency matrix packed as a bit vector can be
+ * optionally added to a graph using the method UseAdjacencyMatrix,
+ * making HasEdge a single bit test. With the ADJ_MATRIX_AUTO
+ * policy the matrix is built only if the graph is small or dense
+ * enough for the matrix not to waste too much memory.
+ *
+ * An undirected graph (see IsUndirected) keeps a single list of 
+ * neighbors for each node, and the 'in' vectors are just aliases
+ * of the 'out' vectors: so each edge appears as an 'out' edge
+ * (and as an 'in' edge) of both its ends, as if it were given in
+ * both directions, but the vectors take half the memory. Edge
+ * attributes stored by value are kept once for each end.
+ * The loader of an undirected graph may give an edge once, or
+ * in both directions; in the latter case only the attribute of
+ * the edge whose source has the lower id is used, but the other
+ * one, if stored by pointer, is still destroyed with the graph.
+ *
+ * The heap memory used by a graph is reported by MemoryUsage,
+ * and can be estimated in advance from the number of nodes and
+ * edges using EstimateMemoryUsage; the matching states have
+ * similar methods (see state.h), so that the memory needed by a
+ * match can be known before starting it (see match.h).
+ *
+ * The matching states of the VF2 family can reject most of the
+ * impossible pairs of nodes without looking at their edges if
+ * both graphs have node signatures (see UseSignatures): a 64-bit
+ * word for each node, holding its 'out' and 'in' degrees 
+ * (saturated at SIG_MAX_DEGREE) and, if the graph has int node
+ * labels, a Bloom filter of the labels of its neighbors, with a
+ * bit for each (label, direction) pair. For an isomorphism the
+ * signatures of the paired nodes must be equal; for a
+ * graph-subgraph isomorphism or a monomorphism the node of the
+ * second graph must dominate the node of the first one (see 
+ * SubSignature). The labels are used only if both graphs have
+ * int node labels, since then the nodes are compared by label
+ * equality.
+ *
+ * A graph can be built with its nodes renumbered so as to improve
+ * the locality of the matching (see relabel.h). In this case the
+ * graph keeps the original id of each node (see OriginalId), and
+ * the match functions report the matched nodes using the
+ * original ids.
  --------------------------------------------------------------------*/
 
 #ifndef ARGRAPH_H
@@ -82,8 +173,13 @@ const true=1
 typedef unsigned char byte;
 #endif
 
+#ifdef VF_LARGE_GRAPHS
+typedef unsigned int node_id;
+const node_id NULL_NODE=0xFFFFFFFF;
+#else
 typedef unsigned short node_id;
 const node_id NULL_NODE=0xFFFF;
+#endif
 
 /*----------------------------------------------------------------
  * Abstract class ARGLoader. Allows to construct an ARGraph
@@ -97,6 +193,7 @@ class ARGLoader
       virtual void *GetNodeAttr(node_id node) = 0;
       virtual int OutEdgeCount(node_id node) = 0;
       virtual node_id GetOutEdge(node_id node, int i, void **pattr)=0;
+      virtual void GetOutEdges(node_id node, node_id *dest, void **attrs);
   };
 
 
@@ -139,25 +236,125 @@ class ARGraph_impl
       typedef bool (*node_compat_fn)(void *, void *);
       typedef bool (*edge_compat_fn)(void *, void *);
 
+      typedef unsigned long long signature_type;
+
 
 
-    private:
-      typedef short count_type;
+    protected:
+      // Type used for the positions in the edge vectors.
+      // With 16-bit node ids there can be at most 65535*65535
+      // edges, so an unsigned int is enough.
+#ifdef VF_LARGE_GRAPHS
+      typedef size_t offset_type;
+#else
+      typedef unsigned int offset_type;
+#endif
 
       int n;              /* number of nodes  */
-      void* *attr;        /* node attributes  */
-      count_type  *in_count;  /* number of 'in' edges for each node */
-      node_id **in;       /* nodes connected by 'in' edges to each node */
-      void* **in_attr;    /* Edge attributes for 'in' edges */
-      count_type  *out_count; /* number of 'out edges for each node */
-      node_id **out;      /* nodes connected by 'out' edges to each node */
-      void* **out_attr;   /* Edge attributes for 'out' edges */
+      void* *attr;        /* node attributes, or NULL if by value */
+      offset_type *in_start;  /* position of the first 'in' edge of each 
+                                 node; in_start[n] is the number of edges
+                                 for a graph built from a loader */
+      offset_type *in_end;    /* position after the last 'in' edge of each
+                                 node; in_start+1 unless the lists are
+                                 separated by gaps (see DynamicGraph) */
+      node_id *in;        /* nodes connected by 'in' edges to each node */
+      void* *in_attr;     /* Edge attributes for 'in' edges, or NULL
+                             if by value */
+      offset_type *in_pos;    /* position in the 'out' vectors of each
+                                 'in' edge, if edge attributes are
+                                 stored by value, or NULL */
+      offset_type *out_start; /* position of the first 'out' edge of each
+                                 node; out_start[n] is the number of edges
+                                 for a graph built from a loader */
+      offset_type *out_end;   /* position after the last 'out' edge of each
+                                 node; out_start+1 unless the lists are
+                                 separated by gaps */
+      offset_type edge_count; /* number of entries in the 'out' lists */
+      offset_type edge_slots; /* size of the edge vectors (edge_count 
+                                 unless there are gaps) */
+      node_id *out;       /* nodes connected by 'out' edges to each node */
+      void* *out_attr;    /* Edge attributes for 'out' edges, or NULL
+                             if by value */
+      size_t node_size;   /* size of a node attribute stored by value,
+                             or 0 if node attributes are pointers */
+      size_t edge_size;   /* size of an edge attribute stored by value,
+                             or 0 if edge attributes are pointers */
+      char *node_values;  /* node attributes stored by value, or NULL */
+      char *edge_values;  /* edge attributes stored by value, in the 
+                             order of the 'out' edges, or NULL */
+      char *storage;      /* the block containing all the above vectors */
+      bool undirected;    /* true if the 'in' vectors are the same as
+                             the 'out' vectors (see IsUndirected) */
+      void **dup_attr;    /* attributes of the edges given in both
+                             directions that are not kept by an
+                             undirected graph (see MakeUndirected),
+                             or NULL */
+      offset_type dup_count;
+
+      int *node_label;    /* int node labels, or NULL */
+      int *edge_label;    /* int labels of the 'out' edges, or NULL */
+      int *in_label;      /* int labels of the 'in' edges, or NULL */
+
+      unsigned *adj_matrix;   /* optional adjacency matrix, one bit for
+                                 each pair of nodes, or NULL */
+      size_t adj_stride;      /* words in each row of adj_matrix */
+
+      int hub_count;          /* number of nodes with a hash table */
+      node_id *hub_node;      /* the hub nodes, in increasing order */
+      offset_type *hub_start; /* position of the table of each hub */
+      unsigned *hub_slot;     /* the hash tables of all the hubs */
+
+      node_id *orig_id;       /* id of each node in the graph it was
+                                 obtained from by relabeling, or NULL */
+      node_id *new_id;        /* inverse of orig_id, or NULL */
+
+      signature_type *signature; /* signature of each node, or NULL */
 
       AttrDestroyer *node_destroyer;  // Used to clean up node attrs
       AttrDestroyer *edge_destroyer;  // Used to clean up edge attrs
       AttrComparator *node_comparator; // Used to test node attr. compat.
       AttrComparator *edge_comparator; // Used to test edge attr. compat.
 
+      // Value returned by FindOutEdge for a non existent edge
+      static const offset_type NO_EDGE=(offset_type)-1;
+
+      // Nodes with up to LINEAR_SEARCH_MAX edges are searched
+      // linearly, nodes with at least HUB_DEGREE edges get
+      // a hash table
+      enum { LINEAR_SEARCH_MAX=8, HUB_DEGREE=256 };
+
+      void InitEmpty();
+      void AllocStorage(offset_type edges);
+      void SetStorage(char *block, offset_type edges);
+      static size_t StorageSize(int n, size_t edges, size_t node_size,
+                                size_t edge_size, bool undirected);
+      size_t IndexMemoryUsage();
+      size_t HubTablesSize();
+      void *OutAttr(offset_type pos);
+      void *InAttr(offset_type pos);
+      void StoreValue(char *dest, void *value, size_t size);
+      void BuildInEdges();
+      void MakeUndirected();
+      void BuildHubTables();
+      void ComputeSignature(node_id i);
+      offset_type FindOutEdge(node_id n1, node_id n2);
+      offset_type EdgePosition(node_id n1, node_id n2);
+      static int IntLabel(void *attr);
+
+      // Graphs with at least PARALLEL_BUILD_EDGES edges have
+      // their 'in' vectors built using up to MAX_BUILD_THREADS
+      // threads (unless VF_NO_THREADS is defined)
+      enum { PARALLEL_BUILD_EDGES=1<<20, MAX_BUILD_THREADS=8 };
+#ifndef VF_NO_THREADS
+      struct transpose_job;
+      void BuildInEdgesParallel(int threads);
+      static void RunJobs(void (*fn)(transpose_job *), 
+                          transpose_job *jobs, int threads);
+      static void CountJob(transpose_job *job);
+      static void OffsetJob(transpose_job *job);
+      static void ScatterJob(transpose_job *job);
+#endif
 
 
 
@@ -173,11 +370,62 @@ class ARGraph_impl
       void SetEdgeCompat(edge_compat_fn); // For older versions
 
     public:
-      ARGraph_impl(ARGLoader *loader);
+      // Storage of the attributes (see ARGraph)
+      enum { ATTR_BY_POINTER, ATTR_BY_VALUE };
+
+      // Policies for UseAdjacencyMatrix
+      enum { ADJ_MATRIX_NONE, ADJ_MATRIX_AUTO, ADJ_MATRIX_ALWAYS };
+
+      // Limits used by ADJ_MATRIX_AUTO: the matrix must not be
+      // larger than ADJ_MATRIX_MAX_BYTES, nor more than 
+      // ADJ_MATRIX_MAX_RATIO times the size of the 'out' edge vector
+      enum { ADJ_MATRIX_MAX_BYTES=32<<20, ADJ_MATRIX_MAX_RATIO=8 };
+
+      ARGraph_impl(ARGLoader *loader, size_t node_size=0, 
+                   size_t edge_size=0, bool undirected=false);
       virtual ~ARGraph_impl();
 
+      bool UseAdjacencyMatrix(int policy=ADJ_MATRIX_AUTO);
+      size_t AdjacencyMatrixSize();
+
+      virtual size_t MemoryUsage();
+      static size_t EstimateMemoryUsage(int nodes, size_t edges,
+                                        size_t node_size=0, 
+                                        size_t edge_size=0,
+                                        bool undirected=false);
+
+      void UseIntLabels(bool nodes=true, bool edges=true);
+      bool HasIntNodeLabels();
+      bool HasIntEdgeLabels();
+      int NodeLabel(node_id i);
+
+      // Layout of the node signatures (see UseSignatures)
+      static const signature_type SIG_OUT_DEGREE=0x7F;
+      static const signature_type SIG_IN_DEGREE=0x7F00;
+      static const signature_type SIG_DEGREES=0x7F7F;
+      static const signature_type SIG_GUARD=0x8080;
+      static const signature_type SIG_LABELS=~(signature_type)0xFFFF;
+      enum { SIG_MAX_DEGREE=0x7F, SIG_LABEL_BITS=48 };
+
+      void UseSignatures(bool use=true);
+      bool HasSignatures();
+      signature_type NodeSignature(node_id i);
+      static signature_type SignatureMask(ARGraph_impl *g1, 
+                                          ARGraph_impl *g2,
+                                          bool labels=true);
+      static bool SameSignature(signature_type s1, signature_type s2,
+                                signature_type mask);
+      static bool SubSignature(signature_type s1, signature_type s2,
+                               signature_type mask);
+
+      void SetOriginalIds(node_id *ids);
+      node_id *OriginalIds();
+      node_id OriginalId(node_id i);
+      node_id RelabeledId(node_id orig);
+
 
       int NodeCount();
+      bool IsUndirected();
 
       void *GetNodeAttr(node_id i);
       void SetNodeAttr(node_id i, void *attr, bool destroyOld=false);
@@ -204,7 +452,17 @@ class ARGraph_impl
       virtual bool CompatibleNode(void *attr1, void *attr2);
       virtual bool CompatibleEdge(void *attr1, void *attr2);
 
+      bool CompatibleNodes(node_id n1, ARGraph_impl *g2, node_id n2);
+      bool CompatibleOutEdge(node_id n1, int i, 
+                             ARGraph_impl *g2, node_id n2, node_id m2);
+      bool CompatibleInEdge(node_id n1, int i, 
+                            ARGraph_impl *g2, node_id m2, node_id n2);
+      bool CompatibleEdges(node_id a1, node_id b1,
+                           ARGraph_impl *g2, node_id a2, node_id b2);
+
     protected:
+      ARGraph_impl();
+
       virtual void DestroyNode(void *attr);
       virtual void DestroyEdge(void *attr);
   };
@@ -240,7 +498,13 @@ class ARGraph: public ARGraph_impl
 
       /*-------- methods ----------*/
 
-      ARGraph(ARGLoader *loader) : impl(loader) {}
+      // With ATTR_BY_VALUE the attributes are copied into 
+      // the graph (see the implementation notes)
+      ARGraph(ARGLoader *loader, int storage=ATTR_BY_POINTER,
+              bool undirected=false) 
+        : impl(loader, storage==ATTR_BY_VALUE? sizeof(Node): 0,
+                       storage==ATTR_BY_VALUE? sizeof(Edge): 0,
+                       undirected) {}
 
       void SetNodeDestroy(node_destroy_fn fn)
           { ARGraph_impl::SetNodeDestroy((ARGraph_impl::node_destroy_fn) fn); }
@@ -323,19 +587,167 @@ inline int ARGraph_impl::NodeCount()
   { return n;
   } 
 
+/*-----------------------------------------------
+ * True if the graph is undirected
+ ----------------------------------------------*/
+inline bool ARGraph_impl::IsUndirected() 
+  { return undirected;
+  } 
+
 /*----------------------------------------------
  * Attribute of a node
  ---------------------------------------------*/
 inline void * ARGraph_impl::GetNodeAttr(node_id i) 
-  { assert(i<n);
+  { assert(i<(node_id)n);
+    if (node_values!=NULL)
+      return node_values+i*node_size;
     return attr[i];
   }
 
+/*----------------------------------------------
+ * Attribute of the edge at a position of the
+ * 'out' (or 'in') vectors
+ ---------------------------------------------*/
+inline void * ARGraph_impl::OutAttr(offset_type pos) 
+  { if (edge_values!=NULL)
+      return edge_values+pos*edge_size;
+    return out_attr[pos];
+  }
+
+inline void * ARGraph_impl::InAttr(offset_type pos) 
+  { if (edge_values!=NULL)
+      return edge_values+(in_pos!=NULL? in_pos[pos]: pos)*edge_size;
+    return in_attr[pos];
+  }
+
 /*----------------------------------------------
  * Check the presence of an edge
  ---------------------------------------------*/
 inline bool ARGraph_impl::HasEdge(node_id n1, node_id n2)
-    { return HasEdge(n1, n2, NULL);
+    { if (adj_matrix!=NULL)
+        { assert(n1<(node_id)n);
+          assert(n2<(node_id)n);
+          return (adj_matrix[n1*adj_stride+(n2>>5)] >> (n2&31)) & 1;
+        }
+      return HasEdge(n1, n2, NULL);
+    }
+
+/*----------------------------------------------
+ * Memory used by the adjacency matrix (in bytes),
+ * or 0 if the graph has no adjacency matrix
+ ---------------------------------------------*/
+inline size_t ARGraph_impl::AdjacencyMatrixSize()
+    { if (adj_matrix==NULL)
+        return 0;
+      return n*adj_stride*sizeof(adj_matrix[0]);
+    }
+
+/*----------------------------------------------
+ * Position of the edge (n1, n2) in the 'out' 
+ * vectors, or NO_EDGE. Uses the adjacency matrix,
+ * if present, to reject missing edges quickly.
+ ---------------------------------------------*/
+inline ARGraph_impl::offset_type 
+ARGraph_impl::EdgePosition(node_id n1, node_id n2)
+    { assert(n1<(node_id)n);
+      assert(n2<(node_id)n);
+      if (adj_matrix!=NULL && 
+          !((adj_matrix[n1*adj_stride+(n2>>5)] >> (n2&31)) & 1))
+        return NO_EDGE;
+      return FindOutEdge(n1, n2);
+    }
+
+/*----------------------------------------------
+ * Int labels
+ ---------------------------------------------*/
+inline bool ARGraph_impl::HasIntNodeLabels()
+    { return node_label!=NULL;
+    }
+
+inline bool ARGraph_impl::HasIntEdgeLabels()
+    { return edge_label!=NULL;
+    }
+
+inline int ARGraph_impl::NodeLabel(node_id i)
+    { assert(i<(node_id)n);
+      assert(node_label!=NULL);
+      return node_label[i];
+    }
+
+/*----------------------------------------------
+ * Returns true if the graph has node signatures
+ ---------------------------------------------*/
+inline bool ARGraph_impl::HasSignatures()
+    { return signature!=NULL;
+    }
+
+/*----------------------------------------------
+ * Returns the signature of a node; the graph
+ * must have signatures (see UseSignatures)
+ ---------------------------------------------*/
+inline ARGraph_impl::signature_type ARGraph_impl::NodeSignature(node_id i)
+    { assert(i<(node_id)n);
+      assert(signature!=NULL);
+      return signature[i];
+    }
+
+/*----------------------------------------------
+ * Tests whether two nodes whose signatures are
+ * s1 and s2 can be paired by an isomorphism;
+ * only the bits in mask are compared (see 
+ * SignatureMask)
+ ---------------------------------------------*/
+inline bool ARGraph_impl::SameSignature(signature_type s1,
+                                        signature_type s2,
+                                        signature_type mask)
+    { return ((s1^s2) & mask)==0;
+    }
+
+/*----------------------------------------------
+ * Tests whether a node with signature s1 can be
+ * paired with a node with signature s2 by a
+ * monomorphism or a graph-subgraph isomorphism:
+ * its degrees must not be greater, and its
+ * neighbor labels must be a subset.
+ * The degrees are compared all at once: each
+ * degree field has a guard bit above it, which
+ * is still set after the subtraction if and
+ * only if the degree in s1 is not greater.
+ ---------------------------------------------*/
+inline bool ARGraph_impl::SubSignature(signature_type s1,
+                                       signature_type s2,
+                                       signature_type mask)
+    { s1&=mask;
+      s2&=mask;
+      return (((s2|SIG_GUARD)-(s1&SIG_DEGREES)) & SIG_GUARD)==SIG_GUARD &&
+             (s1 & ~s2 & SIG_LABELS)==0;
+    }
+
+/*----------------------------------------------
+ * Vector of the original ids of the nodes, if
+ * the graph has been relabeled (see relabel.h),
+ * or NULL
+ ---------------------------------------------*/
+inline node_id *ARGraph_impl::OriginalIds()
+    { return orig_id;
+    }
+
+/*----------------------------------------------
+ * Original id of a node (i.e. the id it had
+ * before relabeling)
+ ---------------------------------------------*/
+inline node_id ARGraph_impl::OriginalId(node_id i)
+    { assert(i<(node_id)n);
+      return orig_id==NULL? i: orig_id[i];
+    }
+
+/*----------------------------------------------
+ * Current id of the node whose original id
+ * is 'orig'
+ ---------------------------------------------*/
+inline node_id ARGraph_impl::RelabeledId(node_id orig)
+    { assert(orig<(node_id)n);
+      return new_id==NULL? orig: new_id[orig];
     }
 
 /*----------------------------------------------
@@ -354,8 +766,8 @@ inline void* ARGraph_impl::GetEdgeAttr(node_id n1, node_id n2)
  * Number of edges going into a node
  ------------------------------------------------*/
 inline int ARGraph_impl::InEdgeCount(node_id node) 
-  { assert(node<n); 
-    return in_count[node]; 
+  { assert(node<(node_id)n); 
+    return in_end[node]-in_start[node]; 
   }
 
 
@@ -363,8 +775,8 @@ inline int ARGraph_impl::InEdgeCount(node_id node)
  * Number of edges departing from a node
  ------------------------------------------------*/
 inline int ARGraph_impl::OutEdgeCount(node_id node) 
-  { assert(node<n); 
-    return out_count[node]; 
+  { assert(node<(node_id)n); 
+    return out_end[node]-out_start[node]; 
   }
 
 
@@ -372,17 +784,18 @@ inline int ARGraph_impl::OutEdgeCount(node_id node)
  * Number of edges touching a node
  ------------------------------------------------*/
 inline int ARGraph_impl::EdgeCount(node_id node) 
-  { assert(node<n); 
-    return in_count[node]+out_count[node]; 
+  { assert(node<(node_id)n); 
+    return in_end[node]-in_start[node]+
+           out_end[node]-out_start[node]; 
   }
 
 /*------------------------------------------------
  * Gets the other end of an edge entering a node
  -----------------------------------------------*/
 inline node_id ARGraph_impl::GetInEdge(node_id node, int i)
-  { assert(node<n);
-    assert(i<in_count[node]);
-    return in[node][i];
+  { assert(node<(node_id)n);
+    assert(i<InEdgeCount(node));
+    return in[in_start[node]+i];
   }
 
 /*------------------------------------------------
@@ -391,10 +804,11 @@ inline node_id ARGraph_impl::GetInEdge(node_id node, int i)
  -----------------------------------------------*/
 inline node_id ARGraph_impl::GetInEdge(node_id node, int i, 
                                        void **pattr)
-  { assert(node<n);
-    assert(i<in_count[node]);
-    *pattr = in_attr[node][i];
-    return in[node][i];
+  { assert(node<(node_id)n);
+    assert(i<InEdgeCount(node));
+    offset_type pos=in_start[node]+i;
+    *pattr = InAttr(pos);
+    return in[pos];
   }
 
 
@@ -402,9 +816,9 @@ inline node_id ARGraph_impl::GetInEdge(node_id node, int i,
  * Gets the other end of an edge leaving a node
  -----------------------------------------------*/
 inline node_id ARGraph_impl::GetOutEdge(node_id node, int i)
-  { assert(node<n);
-    assert(i<out_count[node]);
-    return out[node][i];
+  { assert(node<(node_id)n);
+    assert(i<OutEdgeCount(node));
+    return out[out_start[node]+i];
   }
 
 /*------------------------------------------------
@@ -413,10 +827,11 @@ inline node_id ARGraph_impl::GetOutEdge(node_id node, int i)
  -----------------------------------------------*/
 inline node_id ARGraph_impl::GetOutEdge(node_id node, int i, 
                                         void **pattr)
-  { assert(node<n);
-    assert(i<out_count[node]);
-    *pattr = out_attr[node][i];
-    return out[node][i];
+  { assert(node<(node_id)n);
+    assert(i<OutEdgeCount(node));
+    offset_type pos=out_start[node]+i;
+    *pattr = OutAttr(pos);
+    return out[pos];
   }
 
 /*-----------------------------------------------------------
@@ -441,6 +856,79 @@ inline bool ARGraph_impl::CompatibleEdge(void *attr1, void *attr2)
   }
 
 
+/*-----------------------------------------------------------
+ * Checks if node n1 of this graph is compatible with node
+ * n2 of g2. If both graphs have int node labels they are
+ * compared inline, otherwise CompatibleNode is used.
+ ----------------------------------------------------------*/
+inline bool ARGraph_impl::CompatibleNodes(node_id n1, 
+                                          ARGraph_impl *g2, node_id n2)
+  { if (node_label!=NULL && g2->node_label!=NULL)
+      { assert(n1<(node_id)n);
+        assert(n2<(node_id)g2->n);
+        return node_label[n1]==g2->node_label[n2];
+      }
+    return CompatibleNode(GetNodeAttr(n1), g2->GetNodeAttr(n2));
+  }
+
+
+/*-----------------------------------------------------------
+ * Checks that g2 has the edge (n2, m2), and that it is 
+ * compatible with the i-th 'out' edge of node n1 of this 
+ * graph. If both graphs have int edge labels they are 
+ * compared inline, otherwise CompatibleEdge is used.
+ ----------------------------------------------------------*/
+inline bool ARGraph_impl::CompatibleOutEdge(node_id n1, int i,
+                                            ARGraph_impl *g2, 
+                                            node_id n2, node_id m2)
+  { assert(n1<(node_id)n);
+    assert(i<OutEdgeCount(n1));
+    offset_type pos2=g2->EdgePosition(n2, m2);
+    if (pos2==NO_EDGE)
+      return false;
+    offset_type pos1=out_start[n1]+i;
+    if (edge_label!=NULL && g2->edge_label!=NULL)
+      return edge_label[pos1]==g2->edge_label[pos2];
+    return CompatibleEdge(OutAttr(pos1), g2->OutAttr(pos2));
+  }
+
+/*-----------------------------------------------------------
+ * Checks that g2 has the edge (m2, n2), and that it is 
+ * compatible with the i-th 'in' edge of node n1 of this 
+ * graph. 
+ ----------------------------------------------------------*/
+inline bool ARGraph_impl::CompatibleInEdge(node_id n1, int i,
+                                           ARGraph_impl *g2, 
+                                           node_id m2, node_id n2)
+  { assert(n1<(node_id)n);
+    assert(i<InEdgeCount(n1));
+    offset_type pos2=g2->EdgePosition(m2, n2);
+    if (pos2==NO_EDGE)
+      return false;
+    offset_type pos1=in_start[n1]+i;
+    if (edge_label!=NULL && g2->edge_label!=NULL)
+      return in_label[pos1]==g2->edge_label[pos2];
+    return CompatibleEdge(InAttr(pos1), g2->OutAttr(pos2));
+  }
+
+/*-----------------------------------------------------------
+ * Checks if the edge (a1, b1) of this graph is compatible
+ * with the edge (a2, b2) of g2. A missing edge is treated
+ * as an edge having a NULL attribute, as GetEdgeAttr does.
+ ----------------------------------------------------------*/
+inline bool ARGraph_impl::CompatibleEdges(node_id a1, node_id b1,
+                                          ARGraph_impl *g2, 
+                                          node_id a2, node_id b2)
+  { offset_type pos1=EdgePosition(a1, b1);
+    offset_type pos2=g2->EdgePosition(a2, b2);
+    if (edge_label!=NULL && g2->edge_label!=NULL &&
+        pos1!=NO_EDGE && pos2!=NO_EDGE)
+      return edge_label[pos1]==g2->edge_label[pos2];
+    return CompatibleEdge(pos1==NO_EDGE? NULL: OutAttr(pos1),
+                          pos2==NO_EDGE? NULL: g2->OutAttr(pos2));
+  }
+
+
 #endif
 /* defined ARGRAPH_H */
 
@@ -0,0 +1,83 @@
+/*--------------------------------------------------------
+ * batch.h
+ * Interface of batch.cc
+ * Matching of a sequence of graph pairs, loading the next
+ * pairs while the current one is being matched.
+ * See: match.h
+ --------------------------------------------------------*/
+
+/*--------------------------------------------------------
+ *   IMPLEMENTATION NOTES
+ *
+ * batch_match gets the graph pairs from a PairLoader, and
+ * passes them in order to a pair_visitor, which usually
+ * builds the initial state and calls match (see match.h).
+ * The visitor runs on the calling thread, while the pairs
+ * that follow are loaded by one or more background threads
+ * into a ring buffer of 'depth' slots: a loader thread
+ * takes the next pair only when its slot has been emptied
+ * by the visitor, so at most 'depth' pairs are loaded ahead
+ * of the one being matched, however slow the matching is.
+ *
+ * PairLoader::Load is only called from the background
+ * threads. With a single thread the pairs are loaded in
+ * order, one at a time, so the loader can read them from a
+ * stream (e.g. a GraphDBStream, see graphdb.h); with more
+ * threads Load is called concurrently for different pairs,
+ * and must be safe to call in that way. The first pair for
+ * which Load returns false ends the sequence; the pairs
+ * after it that have already been loaded are only released.
+ * PairLoader::Release, which by default deletes both the
+ * graphs, is always called on the calling thread, after the
+ * visitor or when a pair is discarded.
+ *
+ * If the library is compiled with VF_NO_THREADS, the pairs
+ * are loaded and matched in turn by the calling thread.
+ --------------------------------------------------------*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "argraph.h"
+
+
+/*--------------------------------------------------------
+ * class PairLoader
+ * Provides the graph pairs of a batch, numbered from 0.
+ -------------------------------------------------------*/
+class PairLoader
+  { public:
+      virtual ~PairLoader() {}
+
+      virtual bool Load(int k, Graph **pg1, Graph **pg2)=0;
+      virtual void Release(int k, Graph *g1, Graph *g2);
+  };
+
+
+/*------------------------------------------------------------
+ * Definition of the pair_visitor type: a function that is
+ * invoked for each pair, in order. If it returns true the
+ * batch is stopped.
+ -----------------------------------------------------------*/
+typedef bool (*pair_visitor)(int k, Graph *g1, Graph *g2,
+                             void *usr_data);
+
+
+/*------------------------------------------------------------
+ * Timings of a batch, in seconds. The load and stall times
+ * are summed over the loader threads.
+ -----------------------------------------------------------*/
+struct batch_stats
+  { int pairs;          /* pairs passed to the visitor */
+    double total_time;  /* wall clock time of batch_match */
+    double load_time;   /* time spent in PairLoader::Load */
+    double match_time;  /* time spent in the visitor */
+    double wait_time;   /* time the visitor waited for a pair */
+    double stall_time;  /* time the loaders waited for a slot */
+  };
+
+
+int batch_match(PairLoader *loader, pair_visitor vis, void *usr_data=NULL,
+                int depth=4, int threads=1, batch_stats *stats=NULL);
+
+#endif
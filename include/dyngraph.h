@@ -0,0 +1,123 @@
+/*--------------------------------------------------------
+ * dyngraph.h
+ * Interface of dyngraph.cc
+ * A graph supporting the insertion of nodes and edges and
+ * the removal of edges.
+ * See: argraph.h
+ --------------------------------------------------------*/
+
+/*--------------------------------------------------------
+ *   IMPLEMENTATION NOTES
+ *
+ * A DynamicGraph is an ARGraph_impl, and so can be given
+ * to any of the matching states; the only difference is in
+ * the way the edge vectors are managed.
+ * Each node has its own region of the 'out' (and 'in')
+ * vectors, which can be larger than its list of edges: the
+ * edges still occupy the positions from out_start[i] to
+ * out_end[i]-1, sorted by destination, and the region ends
+ * at out_start[i]+out_cap[i]. A list that outgrows its
+ * region is moved to the end of the vectors, in a region
+ * twice as large; the vectors are compacted when the space
+ * left behind by the moved lists exceeds the space used by
+ * the edges.
+ *
+ * The graph edit operations are not applied immediately:
+ * AddEdge and RemoveEdge just append the operation to a
+ * queue (in constant time), and Commit applies all the
+ * queued operations at once, sorting them and merging them
+ * into the lists of the nodes they touch. So the cost of a
+ * batch of k operations is O(k log k) plus the length of the
+ * lists touched, independently of the size of the graph.
+ * The operations are applied in the order they were issued;
+ * adding an existing edge or removing a non existent one is
+ * an error (detected by Commit). As in ARGEdit, the
+ * attribute of a removed edge is destroyed (see
+ * SetEdgeDestroyer).
+ * AddNode returns the id of the new node immediately, so
+ * that edges involving it can be queued, but the node becomes
+ * part of the graph only with the next Commit. Nodes cannot
+ * be removed. The operations still queued when the graph is
+ * deleted are discarded, without destroying their attributes.
+ *
+ * Until Commit is called the graph (as seen by the other
+ * methods and by the matching states) is unchanged; Commit
+ * must not be called while the graph is being matched.
+ * The adjacency matrix, the int labels and the node
+ * signatures, if used, are kept up to date by Commit; the attributes are always
+ * stored by pointer, and no hash table is built for the
+ * hub nodes.
+ --------------------------------------------------------*/
+
+#ifndef DYNGRAPH_H
+#define DYNGRAPH_H
+
+#include "argraph.h"
+
+
+/*--------------------------------------------------------
+ * class DynamicGraph
+ -------------------------------------------------------*/
+class DynamicGraph: public ARGraph_impl
+  { public:
+      DynamicGraph();
+      DynamicGraph(ARGLoader *loader);
+      ~DynamicGraph();
+
+      node_id AddNode(void *attr);
+      void AddEdge(node_id n1, node_id n2, void *attr);
+      void RemoveEdge(node_id n1, node_id n2);
+      void Commit();
+
+      int PendingCount();
+
+      virtual size_t MemoryUsage();
+
+    protected:
+      struct edge_op
+        { node_id from;
+          node_id to;
+          int seq;         /* order of issue */
+          bool remove;
+          void *attr;
+        };
+
+      int node_cap;              /* size of the node vectors */
+      offset_type *out_cap;      /* size of the region of each 'out' list */
+      offset_type *in_cap;       /* size of the region of each 'in' list */
+      offset_type out_used;      /* end of the last 'out' region */
+      offset_type in_used;       /* end of the last 'in' region */
+      offset_type out_free;      /* space left behind by moved 'out' lists */
+      offset_type in_free;       /* space left behind by moved 'in' lists */
+      int new_nodes;             /* nodes added since the last Commit */
+
+      edge_op *ops;              /* queued edge operations */
+      int op_count, op_cap;
+
+      node_id *tmp_id;           /* buffers used to merge a list */
+      void* *tmp_attr;
+      offset_type tmp_cap;
+
+      // Minimum size of the region of a list that has been moved,
+      // and free space tolerated before compacting the vectors
+      enum { MIN_LIST_CAP=4, COMPACT_SLACK=64 };
+
+      void Init();
+      void GrowNodes(int cap);
+      void GrowSlots(offset_type cap);
+      void MergeList(node_id node, edge_op *op, int count, bool in_side);
+      void Compact();
+      static int OutOrderComp(const void *a, const void *b);
+      static int InOrderComp(const void *a, const void *b);
+  };
+
+
+/*----------------------------------------------------------
+ * Number of edge operations waiting for the next Commit
+ ---------------------------------------------------------*/
+inline int DynamicGraph::PendingCount()
+  { return op_count;
+  }
+
+
+#endif
@@ -0,0 +1,226 @@
+/*--------------------------------------------------------
+ * graphdb.h
+ * Interface of graphdb.cc
+ * A file holding a collection of graphs, with an index
+ * allowing the access to any of them.
+ * See: argraph.h
+ --------------------------------------------------------*/
+
+/*--------------------------------------------------------
+ *   IMPLEMENTATION NOTES
+ *
+ * A graph database file starts with a header, followed by
+ * one record for each graph and by an index. Each record
+ * holds the edges of a graph in compressed sparse row form
+ * (the position of the first edge of each node, and the
+ * destinations of all the edges), followed by the node and
+ * edge attributes, if they are saved. The edges of an
+ * undirected graph are saved only once.
+ * The index gives, for each graph, the position of its
+ * record, its number of nodes and edges, and optionally
+ * a histogram of its int node labels (see
+ * ARGraph_impl::UseIntLabels): label l is counted in bin
+ * l mod LabelBins(). These metadata can be used to discard
+ * the graphs that cannot contain a pattern without reading
+ * them.
+ *
+ * GraphDBWriter builds the file from existing graphs; the
+ * stream must be seekable, since the header is completed
+ * when the writer is closed.
+ * GraphDB reads the header and the index when it is opened,
+ * and then reads a graph with a single seek, independently
+ * of the number and the size of the other graphs.
+ * GraphDBStream reads the graphs in order, without seeking
+ * (so it can also read from a pipe).
+ * Both fill a GraphDBLoader, an ARGLoader which can be
+ * passed to the constructor of any graph class, and which
+ * reuses its buffer from one graph to the next.
+ *
+ * As with MappedGraph (see mapgraph.h), only attributes of a
+ * fixed size, stored by value, can be saved: node_size
+ * (edge_size) bytes are copied from each node (edge)
+ * attribute, and the graphs should be built with the same
+ * sizes. If the size is 0 the attributes are not saved, and
+ * the loader returns NULL attributes.
+ * Node ids and edge counts are saved as 32-bit numbers; the
+ * file is in the byte order of the machine that wrote it, and
+ * is rejected by a machine with a different byte order.
+ --------------------------------------------------------*/
+
+#ifndef GRAPHDB_H
+#define GRAPHDB_H
+
+#include <iostream>
+
+#include "argraph.h"
+
+
+struct graphdb_entry;
+
+
+/*--------------------------------------------------------
+ * class GraphDBLoader
+ * An ARGLoader for a graph read from a graph database
+ -------------------------------------------------------*/
+class GraphDBLoader: public ARGLoader
+  { friend class GraphDB;
+    friend class GraphDBStream;
+
+    private:
+      char *buffer;        /* the record of the graph */
+      size_t buffer_size;
+      int n;
+      bool undirected;
+      unsigned *start;     /* position of the first edge of each node */
+      unsigned *dest;      /* destination of each edge */
+      char *node_values;   /* node attributes, or NULL */
+      char *edge_values;   /* edge attributes, or NULL */
+      size_t node_size, edge_size;
+
+      void Read(std::istream &in, size_t node_size, size_t edge_size);
+
+    public:
+      GraphDBLoader();
+      ~GraphDBLoader();
+
+      virtual int NodeCount();
+      virtual void *GetNodeAttr(node_id node);
+      virtual int OutEdgeCount(node_id node);
+      virtual node_id GetOutEdge(node_id node, int i, void **pattr);
+      virtual void GetOutEdges(node_id node, node_id *dest, void **attrs);
+
+      bool IsUndirected();
+      Graph *NewGraph();
+  };
+
+
+/*--------------------------------------------------------
+ * class GraphDBWriter
+ -------------------------------------------------------*/
+class GraphDBWriter
+  { private:
+      std::ostream &out;
+      size_t node_size, edge_size;
+      int label_bins;
+      std::ostream::pos_type base; /* position of the header */
+      size_t pos;          /* current position, from base */
+      size_t count;        /* graphs written so far */
+      size_t capacity;     /* size of the vectors below */
+      graphdb_entry *index;
+      unsigned *hist;      /* label histograms */
+      char *buffer;        /* the record being built */
+      size_t buffer_size;
+      bool closed;
+
+    public:
+      GraphDBWriter(std::ostream &out, size_t node_size=0,
+                    size_t edge_size=0, int label_bins=0);
+      ~GraphDBWriter();
+
+      void Add(Graph &g);
+      void Close();
+  };
+
+
+/*--------------------------------------------------------
+ * class GraphDB
+ * Random access to the graphs of a database
+ -------------------------------------------------------*/
+class GraphDB
+  { private:
+      std::istream &in;
+      std::istream::pos_type base; /* position of the header */
+      size_t count;
+      size_t node_size, edge_size;
+      int label_bins;
+      graphdb_entry *index;
+      unsigned *hist;       /* label histograms */
+
+    public:
+      GraphDB(std::istream &in);
+      ~GraphDB();
+
+      int GraphCount();
+      size_t NodeAttrSize();
+      size_t EdgeAttrSize();
+      int LabelBins();
+
+      int NodeCount(int k);
+      int EdgeCount(int k);
+      bool IsUndirected(int k);
+      unsigned LabelCount(int k, int bin);
+
+      void Read(int k, GraphDBLoader &loader);
+      Graph *NewGraph(int k);
+  };
+
+
+/*--------------------------------------------------------
+ * class GraphDBStream
+ * Sequential access to the graphs of a database
+ -------------------------------------------------------*/
+class GraphDBStream
+  { private:
+      std::istream &in;
+      size_t count;        /* graphs in the database */
+      size_t next;         /* graphs read so far */
+      size_t node_size, edge_size;
+
+    public:
+      GraphDBStream(std::istream &in);
+
+      int GraphCount();
+      bool Next(GraphDBLoader &loader);
+  };
+
+
+/*---------------------------------------------------------------------
+ * INLINE METHODS
+ ---------------------------------------------------------------------*/
+inline int GraphDBLoader::NodeCount()
+  { return n;
+  }
+
+inline void *GraphDBLoader::GetNodeAttr(node_id node)
+  { assert(node<(node_id)n);
+    return node_values==NULL? NULL: node_values+node*node_size;
+  }
+
+inline int GraphDBLoader::OutEdgeCount(node_id node)
+  { assert(node<(node_id)n);
+    return start[node+1]-start[node];
+  }
+
+inline node_id GraphDBLoader::GetOutEdge(node_id node, int i, void **pattr)
+  { assert(node<(node_id)n);
+    unsigned e=start[node]+i;
+    if (pattr!=NULL)
+      *pattr=(edge_values==NULL)? NULL: edge_values+e*edge_size;
+    return dest[e];
+  }
+
+inline bool GraphDBLoader::IsUndirected()
+  { return undirected;
+  }
+
+inline int GraphDB::GraphCount()
+  { return count;
+  }
+
+inline size_t GraphDB::NodeAttrSize()
+  { return node_size;
+  }
+
+inline size_t GraphDB::EdgeAttrSize()
+  { return edge_size;
+  }
+
+inline int GraphDB::LabelBins()
+  { return label_bins;
+  }
+
+inline int GraphDBStream::GraphCount()
+  { return count;
+  }
+
+#endif
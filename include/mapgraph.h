@@ -0,0 +1,89 @@
+/*--------------------------------------------------------
+ * mapgraph.h
+ * Interface of mapgraph.cc
+ * A graph loaded by mapping into memory a file holding
+ * its edge vectors.
+ * See: argraph.h
+ --------------------------------------------------------*/
+
+/*--------------------------------------------------------
+ *   IMPLEMENTATION NOTES
+ *
+ * MappedGraph::write saves a graph as an image of the
+ * storage block of ARGraph_impl (the compressed sparse row
+ * vectors, laid out as in AllocStorage) followed by the hash
+ * tables of the hub nodes, preceded by a small header.
+ * The constructor of MappedGraph maps the file into memory
+ * with mmap, checks the header, and points the vectors of the
+ * graph into the mapped block: nothing is copied, and
+ * nothing proportional to the size of the graph is computed,
+ * so the time needed to open a graph is independent of its
+ * size; the pages of the file are read by the operating system
+ * when the matching first touches them, and are shared by all
+ * the processes mapping the same file.
+ *
+ * The image is in the native format of the machine that
+ * wrote it (byte order, sizeof(node_id), which depends on
+ * VF_LARGE_GRAPHS, and the size of the edge positions): a
+ * file written with a different format is rejected. Apart
+ * from the header, the contents of the file are trusted.
+ *
+ * Only attributes stored by value (see ARGraph_impl) can be
+ * saved: write copies node_size (edge_size) bytes of each
+ * node (edge) attribute, and the mapped graph has its
+ * attributes stored by value, with the same sizes. With a
+ * size of 0 the attributes are not saved, and the mapped
+ * graph has NULL attributes; they can be set with
+ * SetNodeAttr/SetEdgeAttr, but are never destroyed by the
+ * graph. Since the file is an image of the storage block, it
+ * still contains the (zeroed) vectors of the attribute
+ * pointers; their pages are never read unless the attributes
+ * are used.
+ * The file is mapped privately: any change to the graph
+ * (e.g. by SetNodeAttr) is seen only by the process that made
+ * it, and is not written back to the file. The int labels,
+ * the node signatures and the adjacency matrix are not saved,
+ * but can be computed as usual after the graph is mapped.
+ *
+ * A BinaryGraphLoader file (see argloader.h) is still the
+ * portable way of exchanging graphs.
+ --------------------------------------------------------*/
+
+#ifndef MAPGRAPH_H
+#define MAPGRAPH_H
+
+#include <iostream>
+
+#include "argraph.h"
+
+
+/*--------------------------------------------------------
+ * class MappedGraph
+ -------------------------------------------------------*/
+class MappedGraph: public ARGraph_impl
+  { private:
+      char *map_base;     /* the mapped file, or NULL */
+      size_t map_size;    /* the size of the mapping */
+
+      MappedGraph(Graph *g, size_t node_size, size_t edge_size);
+
+    public:
+      MappedGraph(const char *filename);
+      ~MappedGraph();
+
+      virtual size_t MemoryUsage();
+      size_t MappedSize();
+
+      static void write(std::ostream &out, Graph &g,
+                        size_t node_size=0, size_t edge_size=0);
+  };
+
+
+/*---------------------------------------------------------------------
+ * INLINE METHODS
+ ---------------------------------------------------------------------*/
+inline size_t MappedGraph::MappedSize()
+  { return map_size;
+  }
+
+#endif
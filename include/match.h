@@ -29,12 +29,102 @@
  * each match that has been found.
  * If the function returns false, then the next match is
  * searched; else the seach process terminates.
+ * The nodes are reported using their original ids if the
+ * graphs have been relabeled (see relabel.h).
  -----------------------------------------------------------*/
 typedef bool (*match_visitor)(int n, node_id c1[], node_id c2[], 
                               void *usr_data);
 
 bool match(State *s0, int *pn, node_id c1[], node_id c2[]);
 
+/* Returns the number of visited matches, or INT_MAX if they are
+ * more (see limited_match for a 64-bit count) */
 int match(State *s0, match_visitor vis, void *usr_data=NULL);
 
+
+/*------------------------------------------------------------
+ * parallel_match visits all the matches as match(s0, vis,
+ * usr_data) does, using 'threads' threads (one for each
+ * processor if threads is 0). The matches are visited in no
+ * particular order; the visitor is called by one thread at a
+ * time (any of them, the calling one included), and is never
+ * called again after it has returned true. The return value
+ * is the number of visitor calls, or INT_MAX if they are more.
+ * The search is done on copies of s0 made by Fork, and s0 is
+ * left unchanged. If the state class does not support Fork
+ * (see state.h), or the library has been compiled with
+ * VF_NO_THREADS, parallel_match just calls match.
+ -----------------------------------------------------------*/
+int parallel_match(State *s0, match_visitor vis, void *usr_data=NULL,
+                   int threads=0);
+
+
+/*------------------------------------------------------------
+ * Limits of a search done by limited_match; a value of 0
+ * means no limit. The number of states counts the pairs
+ * added to a state during the search, i.e. the nodes of the
+ * search tree that have been expanded; max_time is in seconds
+ * from the start of the call, and is checked at least once
+ * every few hundreds pairs tried.
+ -----------------------------------------------------------*/
+struct match_limits
+  { long long max_matches;  /* visited matches */
+    long max_states;        /* states made */
+    double max_time;        /* wall clock time */
+  };
+
+/*------------------------------------------------------------
+ * Status of a search done by limited_match: complete, stopped
+ * by the visitor, or truncated by one of the limits (also
+ * when max_matches matches have been visited and there are
+ * no more)
+ -----------------------------------------------------------*/
+enum { MATCH_COMPLETE, MATCH_STOPPED, MATCH_MAX_MATCHES,
+       MATCH_MAX_STATES, MATCH_TIMEOUT };
+
+int limited_match(State *s0, match_visitor vis, void *usr_data,
+                  const match_limits *limits, long long *pcount=NULL);
+
+
+/*------------------------------------------------------------
+ * match_count counts the matches that match(s0, vis, ...)
+ * would visit, without extracting them from the states and
+ * without calling a visitor, so it is the fastest way of
+ * finding only their number. The count is 64-bit. The
+ * search can be limited as for limited_match, the status
+ * being put in *pstatus if pstatus is not NULL.
+ -----------------------------------------------------------*/
+long long match_count(State *s0, const match_limits *limits=NULL,
+                      int *pstatus=NULL);
+
+
+/*------------------------------------------------------------
+ * A level of the search done by match: a state, and the last
+ * pair that has been tried from it
+ -----------------------------------------------------------*/
+struct match_frame
+  { State *s;
+    node_id n1, n2;
+  };
+
+
+/*------------------------------------------------------------
+ * Estimates the peak heap memory (in bytes) of a match call
+ * using states of class S, between a graph with n1 nodes and
+ * e1 edges, and a graph with n2 nodes and e2 edges: the 
+ * graphs (with the attributes stored by pointer; see 
+ * ARGraph_impl::EstimateMemoryUsage), the states and the 
+ * vectors allocated by match. The attributes themselves are 
+ * not included. 
+ -----------------------------------------------------------*/
+template <class S>
+size_t EstimateMatchMemory(int n1, size_t e1, int n2, size_t e2)
+  { int n=(n1>n2)? n1: n2;
+    return ARGraph_impl::EstimateMemoryUsage(n1, e1) +
+           ARGraph_impl::EstimateMemoryUsage(n2, e2) +
+           S::PeakMemoryUsage(n1, n2) +
+           2*n*sizeof(node_id) +
+           (n+1)*sizeof(match_frame);
+  }
+
 #endif
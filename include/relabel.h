@@ -0,0 +1,97 @@
+/*--------------------------------------------------------
+ * relabel.h
+ * Interface of relabel.cc
+ * Renumbering of the nodes of a graph to improve the
+ * locality of the matching process.
+ * See: argraph.h
+ --------------------------------------------------------*/
+
+/*--------------------------------------------------------
+ *   IMPLEMENTATION NOTES
+ *
+ * The node ids of a graph are used as indices both in the
+ * edge vectors of the graph and in the vectors of the
+ * matching states (core, in and out sets). If the ids come
+ * from a source that does not preserve any locality, the
+ * nodes that are adjacent in the graph end up far apart in
+ * those vectors.
+ * A RelabelLoader wraps another ARGLoader and presents the
+ * same graph with the nodes renumbered in one of the
+ * following orders:
+ *   RELABEL_BFS     breadth-first visit, ignoring the
+ *                   direction of the edges
+ *   RELABEL_RCM     reverse Cuthill-McKee (a breadth-first
+ *                   visit starting from a node of minimum
+ *                   degree, visiting the neighbors by
+ *                   increasing degree, reversed)
+ *   RELABEL_DEGREE  by decreasing number of edges
+ * The graph built from a RelabelLoader must be given the
+ * permutation by calling AttachTo, after which it is owned
+ * by the graph; the match functions (see match.h) use it to
+ * report the matched nodes with their original ids, while
+ * OriginalId/RelabeledId translate single ids.
+ * NewRelabeledGraph does the whole job for any class
+ * derived from ARGraph_impl.
+ --------------------------------------------------------*/
+
+#ifndef RELABEL_H
+#define RELABEL_H
+
+#include "argraph.h"
+
+enum { RELABEL_BFS, RELABEL_RCM, RELABEL_DEGREE };
+
+node_id *RelabelingOrder(Graph *g, int method);
+
+
+/*--------------------------------------------------------
+ * class RelabelLoader
+ * An ARGLoader presenting the graph of another loader with
+ * the nodes renumbered. The source loader is read entirely
+ * by the constructor. The attributes are not copied, nor
+ * destroyed.
+ -------------------------------------------------------*/
+class RelabelLoader: public ARGLoader
+  { private:
+      struct edge_info
+        { node_id id;
+          void *attr;
+        };
+
+      Graph *g;           /* the graph with the original ids */
+      node_id *order;     /* original id of each new node */
+      node_id *new_id;    /* new id of each original node */
+      edge_info *edges;   /* sorted 'out' edges of node 'cur' */
+      int cur;            /* the node whose edges are in 'edges' */
+
+      void LoadEdges(node_id node);
+
+    public:
+      RelabelLoader(ARGLoader *loader, int method=RELABEL_RCM);
+      virtual ~RelabelLoader();
+
+      void AttachTo(Graph *graph);
+
+      virtual int NodeCount();
+      virtual void *GetNodeAttr(node_id node);
+      virtual int OutEdgeCount(node_id node);
+      virtual node_id GetOutEdge(node_id node, int i, void **pattr);
+      virtual void GetOutEdges(node_id node, node_id *dest, void **attrs);
+  };
+
+
+/*--------------------------------------------------------
+ * Creates a graph of class G (ARGraph_impl or a subclass
+ * of it having a constructor taking an ARGLoader*) with
+ * the nodes of the loader renumbered using the given
+ * method.
+ -------------------------------------------------------*/
+template <class G>
+G *NewRelabeledGraph(ARGLoader *loader, int method=RELABEL_RCM)
+  { RelabelLoader rl(loader, method);
+    G *graph=new G(&rl);
+    rl.AttachTo(graph);
+    return graph;
+  }
+
+#endif
@@ -61,6 +61,10 @@ class SDState: public State
       void GetCoreSet(node_id c1[], node_id c2[]);
       State *Clone();
 
+      size_t MemoryUsage();
+      size_t SharedMemoryUsage();
+      static size_t PeakMemoryUsage(int n1, int n2);
+
 	  void BackTrack();
   };
 
@@ -42,6 +42,35 @@
  *   the parent and the child. The BackTrack implementation
  *   can safely assume that at most one AddPair has been
  *   performed on the state.
+ * MemoryUsage returns the heap memory (in bytes) used by the
+ *   state itself, i.e. by the object and by the vectors that
+ *   are not shared with other states; SharedMemoryUsage 
+ *   returns the memory of the vectors shared by all the states
+ *   of a match (which is not included in MemoryUsage). So the
+ *   memory used by a match with k live states is k times 
+ *   MemoryUsage (roughly) plus SharedMemoryUsage. Both return
+ *   0 by default, for the state classes that do not account
+ *   for their memory.
+ *   Each state class also has a static method
+ *       size_t PeakMemoryUsage(int n1, int n2)
+ *   estimating the peak memory of its states during a match
+ *   between graphs with n1 and n2 nodes (see match.h).
+ * PushPair and PopPair allow a search without cloning: PushPair
+ *   adds a pair to the state itself, as AddPair does, and PopPair
+ *   removes the last pair pushed, restoring the state exactly as
+ *   it was before. A state supporting them returns true from
+ *   CanPushPair, and match then uses a single state object for
+ *   the whole search. A state must not be backtracked while it
+ *   has pairs pushed, nor cloned except by Fork.
+ * Fork returns a copy of the state that shares nothing that is
+ *   changed by the search with the state or its clones, so that
+ *   the copy can be searched by another thread (see
+ *   parallel_match in match.h). A state whose clones share
+ *   their vectors must copy them; a state class that cannot be
+ *   copied in this way returns NULL, the default.
+ *   Fork may be called while the state has pairs pushed: the
+ *   copy holds all the pairs of the state, as if they had been
+ *   added by AddPair, and has no pairs pushed of its own.
  ---------------------------------------------------------*/
 class State
   { 
@@ -61,6 +90,15 @@ class State
       virtual State *Clone() =0;  // Changed clone to Clone for uniformity
      
       virtual void BackTrack() { };
+
+      virtual bool CanPushPair() { return false; }
+      virtual void PushPair(node_id n1, node_id n2) { assert(false); }
+      virtual void PopPair() { assert(false); }
+
+      virtual State *Fork() { return NULL; }
+
+      virtual size_t MemoryUsage() { return 0; }
+      virtual size_t SharedMemoryUsage() { return 0; }
   };
 
 
@@ -64,6 +64,10 @@ class UllSubState: public State
       int CoreLen() { return core_len; }
       void GetCoreSet(node_id c1[], node_id c2[]);
       State *Clone();
+      State *Fork() { return Clone(); } // clones share nothing
+
+      size_t MemoryUsage();
+      static size_t PeakMemoryUsage(int n1, int n2);
   };
 
 
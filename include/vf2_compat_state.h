@@ -0,0 +1,246 @@
+/*------------------------------------------------------------
+ * vf2_compat_state.h
+ * Definition of versions of VF2State, VF2SubState and
+ * VF2MonoState using compile-time attribute comparators.
+ * See: vf2_state.h vf2_sub_state.h vf2_mono_state.h
+ *
+ *-----------------------------------------------------------------*/
+
+/*-----------------------------------------------------------------
+ *   IMPLEMENTATION NOTES
+ *
+ * The classes VF2CompatState<NodeCompat, EdgeCompat>,
+ * VF2SubCompatState<NodeCompat, EdgeCompat> and
+ * VF2MonoCompatState<NodeCompat, EdgeCompat> behave exactly as
+ * VF2State, VF2SubState and VF2MonoState respectively, except
+ * for the attribute compatibility test: instead of the
+ * comparators of the graphs, they use two function objects
+ * whose types are given as template parameters, so that the
+ * compiler can inline the test into IsFeasiblePair.
+ * The function objects must be callable as
+ *     bool compat(void *attr1, void *attr2)
+ * where attr1 is the attribute of g1, and attr2 the attribute
+ * of g2 (as for AttrComparator::compatible). They are passed
+ * by value to the constructor, and copied into each state.
+ * Since the nodes are not compared by their int labels, only
+ * the degrees in the node signatures (if any) are used.
+ * Two function objects are provided: AnyAttrCompat, which
+ * accepts any pair of attributes, and EqualAttrCompat<T>, which
+ * compares two attributes of type T using operator==; a NULL
+ * attribute is only compatible with another NULL attribute.
+ ----------------------------------------------------------------*/
+
+
+#ifndef VF2_COMPAT_STATE_H
+#define VF2_COMPAT_STATE_H
+
+#include "argraph.h"
+#include "state.h"
+#include "vf2_state.h"
+#include "vf2_sub_state.h"
+#include "vf2_mono_state.h"
+
+
+/*----------------------------------------------------------
+ * Predefined function objects
+ ---------------------------------------------------------*/
+struct AnyAttrCompat
+  { bool operator()(void *, void *) const { return true; }
+  };
+
+template <class T>
+struct EqualAttrCompat
+  { bool operator()(void *attr1, void *attr2) const
+      { if (attr1==NULL || attr2==NULL)
+          return attr1==attr2;
+        return *(T *)attr1 == *(T *)attr2;
+      }
+  };
+
+
+/*----------------------------------------------------------
+ * class VF2CompatStateBase
+ * The common implementation of the three templates: derives
+ * from the corresponding state class (Base), replacing only
+ * IsFeasiblePair, Clone and Fork (and the memory accounting,
+ * since the state holds the function objects).
+ ---------------------------------------------------------*/
+template <class Base, int kind, class NodeCompat, class EdgeCompat>
+class VF2CompatStateBase: public Base
+  { protected:
+      using Base::core_1;
+      using Base::core_2;
+      using Base::in_1;
+      using Base::in_2;
+      using Base::out_1;
+      using Base::out_2;
+      using Base::g1;
+      using Base::g2;
+      using Base::n1;
+      using Base::n2;
+      using Base::sig_mask;
+
+      NodeCompat node_compat;
+      EdgeCompat edge_compat;
+
+    public:
+      VF2CompatStateBase(ARGraph_impl *g1, ARGraph_impl *g2, 
+                         bool sortNodes=false,
+                         NodeCompat nc=NodeCompat(),
+                         EdgeCompat ec=EdgeCompat())
+        : Base(g1, g2, sortNodes), node_compat(nc), edge_compat(ec)
+        { sig_mask=ARGraph_impl::SignatureMask(g1, g2, false);
+        }
+
+      bool IsFeasiblePair(node_id n1, node_id n2);
+      State *Clone() { return new VF2CompatStateBase(*this); }
+      State *Fork()
+        { VF2CompatStateBase *s=new VF2CompatStateBase(*this);
+          s->Unshare();
+          return s;
+        }
+
+      size_t MemoryUsage()
+        { return Base::MemoryUsage() +
+                 sizeof(VF2CompatStateBase)-sizeof(Base);
+        }
+      static size_t PeakMemoryUsage(int n1, int n2)
+        { return Base::PeakMemoryUsage(n1, n2) + 
+                 sizeof(VF2CompatStateBase)-sizeof(Base);
+        }
+  };
+
+template <class NodeCompat, class EdgeCompat=NodeCompat>
+using VF2CompatState =
+  VF2CompatStateBase<VF2State, VF2_ISOMORPHISM, NodeCompat, EdgeCompat>;
+
+template <class NodeCompat, class EdgeCompat=NodeCompat>
+using VF2SubCompatState =
+  VF2CompatStateBase<VF2SubState, VF2_SUBGRAPH, NodeCompat, EdgeCompat>;
+
+template <class NodeCompat, class EdgeCompat=NodeCompat>
+using VF2MonoCompatState =
+  VF2CompatStateBase<VF2MonoState, VF2_MONOMORPHISM,
+                     NodeCompat, EdgeCompat>;
+
+
+
+/*---------------------------------------------------------------
+ * bool VF2CompatStateBase::IsFeasiblePair(node1, node2)
+ * Returns true if (node1, node2) can be added to the state.
+ * The same as the IsFeasiblePair of the Base class, but for
+ * the use of node_compat and edge_compat; the edges of g2
+ * are checked only for isomorphism and graph-subgraph
+ * isomorphism.
+ --------------------------------------------------------------*/
+template <class Base, int kind, class NodeCompat, class EdgeCompat>
+bool VF2CompatStateBase<Base, kind, NodeCompat, EdgeCompat>::
+IsFeasiblePair(node_id node1, node_id node2)
+  { assert(node1<(node_id)n1);
+    assert(node2<(node_id)n2);
+    assert(core_1[node1]==NULL_NODE);
+    assert(core_2[node2]==NULL_NODE);
+
+    if (sig_mask!=0)
+      { ARGraph_impl::signature_type s1=g1->NodeSignature(node1);
+        ARGraph_impl::signature_type s2=g2->NodeSignature(node2);
+        if (kind==VF2_ISOMORPHISM? 
+               !ARGraph_impl::SameSignature(s1, s2, sig_mask):
+               !ARGraph_impl::SubSignature(s1, s2, sig_mask))
+          return false;
+      }
+
+    if (!node_compat(g1->GetNodeAttr(node1), g2->GetNodeAttr(node2)))
+      return false;
+
+    int i;
+    node_id other1, other2;
+    void *attr1, *attr2;
+    int termout1=0, termout2=0, termin1=0, termin2=0, new1=0, new2=0;
+
+    // Check the 'out' edges of node1
+    for(i=0; i<g1->OutEdgeCount(node1); i++)
+      { other1=g1->GetOutEdge(node1, i, &attr1);
+        if (core_1[other1] != NULL_NODE)
+          { other2=core_1[other1];
+            if (!g2->HasEdge(node2, other2, &attr2) ||
+                !edge_compat(attr1, attr2))
+              return false;
+          }
+        else
+          { if (in_1[other1])
+              termin1++;
+            if (out_1[other1])
+              termout1++;
+            if (!in_1[other1] && !out_1[other1])
+              new1++;
+          }
+      }
+
+    // Check the 'in' edges of node1
+    for(i=0; i<g1->InEdgeCount(node1); i++)
+      { other1=g1->GetInEdge(node1, i, &attr1);
+        if (core_1[other1]!=NULL_NODE)
+          { other2=core_1[other1];
+            if (!g2->HasEdge(other2, node2, &attr2) ||
+                !edge_compat(attr1, attr2))
+              return false;
+          }
+        else
+          { if (in_1[other1])
+              termin1++;
+            if (out_1[other1])
+              termout1++;
+            if (!in_1[other1] && !out_1[other1])
+              new1++;
+          }
+      }
+
+
+    // Check the 'out' edges of node2
+    for(i=0; i<g2->OutEdgeCount(node2); i++)
+      { other2=g2->GetOutEdge(node2, i);
+        if (core_2[other2]!=NULL_NODE)
+          { other1=core_2[other2];
+            if (kind!=VF2_MONOMORPHISM && !g1->HasEdge(node1, other1))
+              return false;
+          }
+        else
+          { if (in_2[other2])
+              termin2++;
+            if (out_2[other2])
+              termout2++;
+            if (!in_2[other2] && !out_2[other2])
+              new2++;
+          }
+      }
+
+    // Check the 'in' edges of node2
+    for(i=0; i<g2->InEdgeCount(node2); i++)
+      { other2=g2->GetInEdge(node2, i);
+        if (core_2[other2] != NULL_NODE)
+          { other1=core_2[other2];
+            if (kind!=VF2_MONOMORPHISM && !g1->HasEdge(other1, node1))
+              return false;
+          }
+        else
+          { if (in_2[other2])
+              termin2++;
+            if (out_2[other2])
+              termout2++;
+            if (!in_2[other2] && !out_2[other2])
+              new2++;
+          }
+      }
+
+    if (kind==VF2_ISOMORPHISM)
+      return termin1==termin2 && termout1==termout2 && new1==new2;
+    else if (kind==VF2_SUBGRAPH)
+      return termin1<=termin2 && termout1<=termout2 && new1<=new2;
+    else
+      return termin1<=termin2 && termout1<=termout2
+	      && (termin1+termout1+new1)<=(termin2+termout2+new2);
+  }
+
+
+#endif
@@ -27,9 +27,9 @@
 class VF2MonoState: public State
   { typedef ARGraph_impl Graph;
 
-    private:
+    protected:
       int core_len, orig_core_len;
-      int added_node1;
+      node_id added_node1;
       int t1both_len, t2both_len, t1in_len, t1out_len, 
           t2in_len, t2out_len; // Core nodes are also counted by these...
       node_id *core_1;
@@ -43,8 +43,19 @@ class VF2MonoState: public State
 
       Graph *g1, *g2;
       int n1, n2;
+      ARGraph_impl::signature_type sig_mask; // signature bits to compare
 
 	  long *share_count;
+
+      struct pushed_pair    // saved by PushPair (see PopPair)
+        { node_id node1, added_node1;
+          int t1both_len, t2both_len, t1in_len, t1out_len,
+              t2in_len, t2out_len;
+        };
+      pushed_pair *pushed;  // one for each pair pushed, or NULL
+
+      void UndoPair(node_id node1);
+      void Unshare();
     
     public:
       VF2MonoState(Graph *g1, Graph *g2, bool sortNodes=false);
@@ -65,8 +76,20 @@ class VF2MonoState: public State
       int CoreLen() { return core_len; }
       void GetCoreSet(node_id c1[], node_id c2[]);
       State *Clone();
+      State *Fork();
+
+      size_t MemoryUsage()
+        { return sizeof(VF2MonoState) +
+                 (pushed!=NULL? n1*sizeof(pushed_pair): 0);
+        }
+      size_t SharedMemoryUsage();
+      static size_t PeakMemoryUsage(int n1, int n2);
 
       virtual void BackTrack();
+
+      bool CanPushPair() { return true; }
+      void PushPair(node_id n1, node_id n2);
+      void PopPair();
   };
 
 
@@ -18,6 +18,14 @@
 #include "state.h"
 
 
+/*----------------------------------------------------------
+ * Kinds of matching, selecting the feasibility rules of the
+ * state templates derived from the VF2 algorithm
+ * (see vf2_compat_state.h and vf2_undir_state.h)
+ ---------------------------------------------------------*/
+enum { VF2_ISOMORPHISM, VF2_SUBGRAPH, VF2_MONOMORPHISM };
+
+
 
 /*----------------------------------------------------------
  * class VF2State
@@ -27,9 +35,9 @@
 class VF2State: public State
   { typedef ARGraph_impl Graph;
 
-    private:
+    protected:
       int core_len, orig_core_len;
-      int added_node1;
+      node_id added_node1;
       int t1both_len, t2both_len, t1in_len, t1out_len, 
           t2in_len, t2out_len; // Core nodes are also counted by these...
       node_id *core_1;
@@ -43,8 +51,19 @@ class VF2State: public State
 
       Graph *g1, *g2;
       int n1, n2;
+      ARGraph_impl::signature_type sig_mask; // signature bits to compare
 
 	  long *share_count;
+
+      struct pushed_pair    // saved by PushPair (see PopPair)
+        { node_id node1, added_node1;
+          int t1both_len, t2both_len, t1in_len, t1out_len,
+              t2in_len, t2out_len;
+        };
+      pushed_pair *pushed;  // one for each pair pushed, or NULL
+
+      void UndoPair(node_id node1);
+      void Unshare();
     
     public:
       VF2State(Graph *g1, Graph *g2, bool sortNodes=false);
@@ -65,8 +84,20 @@ class VF2State: public State
       int CoreLen() { return core_len; }
       void GetCoreSet(node_id c1[], node_id c2[]);
       State *Clone();
+      State *Fork();
+
+      size_t MemoryUsage()
+        { return sizeof(VF2State) +
+                 (pushed!=NULL? n1*sizeof(pushed_pair): 0);
+        }
+      size_t SharedMemoryUsage();
+      static size_t PeakMemoryUsage(int n1, int n2);
 
 	  virtual void BackTrack();
+
+      bool CanPushPair() { return true; }
+      void PushPair(node_id n1, node_id n2);
+      void PopPair();
   };
 
 
@@ -0,0 +1,116 @@
+/*------------------------------------------------------------
+ * vf2_undir_state.h
+ * Interface of vf2_undir_state.cc
+ * Definition of the states of the VF2 algorithm for
+ * undirected graphs.
+ * See: argraph.h state.h vf2_state.h
+ *
+ *-----------------------------------------------------------------*/
+
+/*-----------------------------------------------------------------
+ *   IMPLEMENTATION NOTES
+ *
+ * For undirected graphs (see ARGraph_impl::IsUndirected) the
+ * 'in' and 'out' edges of a node are the same, and so are the
+ * Tin and Tout sets of VF2: the classes VF2UndirState,
+ * VF2UndirSubState and VF2UndirMonoState keep a single terminal
+ * set for each graph, and visit the neighbors of a node only
+ * once, instead of visiting both its 'out' and 'in' edges.
+ * They find the same matchings as VF2State, VF2SubState and
+ * VF2MonoState respectively, applied to the same graphs with
+ * each edge given in both directions.
+ * The three classes are instances of a template, whose parameter
+ * selects the feasibility rules; both graphs must be undirected.
+ ----------------------------------------------------------------*/
+
+
+#ifndef VF2_UNDIR_STATE_H
+#define VF2_UNDIR_STATE_H
+
+#include "argraph.h"
+#include "state.h"
+#include "vf2_state.h"
+
+
+
+/*----------------------------------------------------------
+ * class VF2UndirStateBase
+ * A representation of the SSR current state
+ * See vf2_undir_state.cc for more details.
+ ---------------------------------------------------------*/
+template <int kind>
+class VF2UndirStateBase: public State
+  { typedef ARGraph_impl Graph;
+
+    protected:
+      int core_len, orig_core_len;
+      node_id added_node1;
+      int t1_len, t2_len; // Core nodes are also counted by these...
+      node_id *core_1;
+      node_id *core_2;
+      node_id *term_1;
+      node_id *term_2;
+
+      node_id *order;
+
+      Graph *g1, *g2;
+      int n1, n2;
+      ARGraph_impl::signature_type sig_mask; // signature bits to compare
+
+      long *share_count;
+
+      struct pushed_pair    // saved by PushPair (see PopPair)
+        { node_id node1, added_node1;
+          int t1_len, t2_len;
+        };
+      pushed_pair *pushed;  // one for each pair pushed, or NULL
+
+      void UndoPair(node_id node1);
+      void Unshare();
+
+    public:
+      VF2UndirStateBase(Graph *g1, Graph *g2, bool sortNodes=false);
+      VF2UndirStateBase(const VF2UndirStateBase &state);
+      ~VF2UndirStateBase();
+      Graph *GetGraph1() { return g1; }
+      Graph *GetGraph2() { return g2; }
+      bool NextPair(node_id *pn1, node_id *pn2,
+                    node_id prev_n1=NULL_NODE, node_id prev_n2=NULL_NODE);
+      bool IsFeasiblePair(node_id n1, node_id n2);
+      void AddPair(node_id n1, node_id n2);
+      bool IsGoal()
+        { return core_len==n1 &&
+                 (kind!=VF2_ISOMORPHISM || core_len==n2);
+        }
+      bool IsDead()
+        { if (kind==VF2_ISOMORPHISM)
+            return n1!=n2 || t1_len!=t2_len;
+          else
+            return n1>n2 || t1_len>t2_len;
+        }
+      int CoreLen() { return core_len; }
+      void GetCoreSet(node_id c1[], node_id c2[]);
+      State *Clone();
+      State *Fork();
+
+      size_t MemoryUsage()
+        { return sizeof(VF2UndirStateBase) +
+                 (pushed!=NULL? n1*sizeof(pushed_pair): 0);
+        }
+      size_t SharedMemoryUsage();
+      static size_t PeakMemoryUsage(int n1, int n2);
+
+      virtual void BackTrack();
+
+      bool CanPushPair() { return true; }
+      void PushPair(node_id n1, node_id n2);
+      void PopPair();
+  };
+
+typedef VF2UndirStateBase<VF2_ISOMORPHISM> VF2UndirState;
+typedef VF2UndirStateBase<VF2_SUBGRAPH> VF2UndirSubState;
+typedef VF2UndirStateBase<VF2_MONOMORPHISM> VF2UndirMonoState;
+
+
+#endif
+
@@ -49,6 +49,21 @@ class VFMonoState: public State
       byte *node_flags_2;
       Graph *g1, *g2;
       int n1, n2;
+
+      struct pushed_pair    // saved by PushPair (see PopPair)
+        { node_id node1, node2;
+          int t1in_len, t1out_len, t2in_len, t2out_len;
+          int log_len;      // length of the log before the pair
+        };
+      struct flag_change    // a flag changed by a pushed pair
+        { byte *flag;
+          byte old;
+        };
+      pushed_pair *pushed;  // one for each pair pushed, or NULL
+      flag_change *log;     // up to 3*(n1+n2) changes
+      int log_len;
+
+      void LogFlags(Graph *g, byte *flags, node_id node);
     
     public:
       VFMonoState(Graph *g1, Graph *g2);
@@ -68,6 +83,14 @@ class VFMonoState: public State
       int CoreLen() { return core_len; }
       void GetCoreSet(node_id c1[], node_id c2[]);
       State *Clone();
+      State *Fork() { return Clone(); } // see the copy constructor
+
+      size_t MemoryUsage();
+      static size_t PeakMemoryUsage(int n1, int n2);
+
+      bool CanPushPair() { return true; }
+      void PushPair(node_id n1, node_id n2);
+      void PopPair();
   };
 
 
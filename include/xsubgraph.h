@@ -7,6 +7,27 @@
  * Author: P. Foggia
  --------------------------------------------------------*/
 
+/*--------------------------------------------------------
+ *   IMPLEMENTATION NOTES
+ *
+ * ExtractSubgraph builds an independent graph, going thru
+ * an ARGEdit; it uses a vector as large as the whole graph
+ * for each extraction.
+ * When many subgraphs have to be extracted from the same
+ * graph, a SubgraphExtractor should be used instead: it
+ * allocates the vectors proportional to the size of the
+ * graph only once, and each extraction touches only the
+ * chosen nodes and their edges. The extracted subgraphs are
+ * SubgraphViews: ordinary graphs (so they can be given to
+ * the matching states) holding just the induced edges among
+ * the chosen nodes, whose attributes are shared with the
+ * original graph. So the original graph must not be deleted
+ * (or its attributes changed) while a view is in use; the
+ * views never destroy the attributes. If the original graph
+ * has int labels or node signatures, the views get them
+ * too (the signatures are computed for the view).
+ --------------------------------------------------------*/
+
 
 #ifndef XSUBGRAPH_H
 #define XSUBGRAPH_H
@@ -18,4 +39,67 @@
 
 Graph* ExtractSubgraph(Graph *g, int nodes, bool connected=true);
 
+
+/*--------------------------------------------------------
+ * class SubgraphView
+ * The subgraph induced by a set of nodes of another graph.
+ * Node i of the view is node ParentId(i) of the original
+ * graph. Created by SubgraphExtractor.
+ -------------------------------------------------------*/
+class SubgraphView: public Graph
+  { friend class SubgraphExtractor;
+
+    private:
+      node_id *parent;    /* id in the original graph of each node */
+
+      SubgraphView(Graph *g, node_id *nodes, int count, node_id *map);
+      void SortOutEdges();
+
+    public:
+      ~SubgraphView();
+
+      virtual size_t MemoryUsage();
+
+      node_id ParentId(node_id i);
+      node_id *ParentIds();
+  };
+
+
+/*--------------------------------------------------------
+ * class SubgraphExtractor
+ * Extracts induced subgraphs from a graph, reusing the
+ * same remapping vectors for all the extractions.
+ -------------------------------------------------------*/
+class SubgraphExtractor
+  { private:
+      Graph *g;
+      node_id *map;       /* position in the subgraph of each node
+                             of g, or NULL_NODE; reset after each
+                             extraction */
+      bool *mark;         /* nodes put in the frontier */
+      node_id *frontier;  /* candidates for a connected extraction */
+
+      SubgraphView *Build(node_id *nodes, int count);
+
+    public:
+      SubgraphExtractor(Graph *g);
+      ~SubgraphExtractor();
+
+      SubgraphView *Extract(node_id *nodes, int count);
+      SubgraphView *ExtractRandom(int nodes, bool connected=true);
+  };
+
+
+/*---------------------------------------------------------------------
+ * INLINE METHODS
+ ---------------------------------------------------------------------*/
+inline node_id SubgraphView::ParentId(node_id i)
+  { assert(i<(node_id)n);
+    return parent[i];
+  }
+
+inline node_id *SubgraphView::ParentIds()
+  { return parent;
+  }
+
 #endif
@@ -19,33 +19,49 @@
  *
  ----------------------------------------------------------*/
 
+#include <string.h>
+
 #include "argedit.h"
 #include "error.h"
 
+
+/*---------------------------------------------------------------
+ * Reallocates a vector, keeping its first 'used' elements
+ --------------------------------------------------------------*/
+template <class T, class S>
+static inline void resize(T* &ptr, S used, S new_size)
+  { T* nptr=new T[new_size];
+    if (nptr==NULL)
+      OUT_OF_MEMORY();
+    if (used>0)
+      memcpy(nptr, ptr, used*sizeof(T));
+    delete[] ptr;
+    ptr=nptr;
+  }
+
 /*----------------------------------------------------------
  * Constructor
  ---------------------------------------------------------*/
 ARGEdit:: ARGEdit() 
-  { count=0;
-    nodes=NULL;
-    lastNode=NULL;
-    lastEdge=NULL;
+  { Init();
   }
 
 /*----------------------------------------------------------
  * Constructor
  ---------------------------------------------------------*/
 ARGEdit:: ARGEdit(ARGraph_impl &g) 
-  { count=0;
-    nodes=NULL;
-    lastNode=NULL;
-    lastEdge=NULL;
+  { Init();
 
     node_id n;
-    for(n=0; n<g.NodeCount(); n++)
-      InsertNode(g.GetNodeAttr(n));
     int i;
-    for(n=0; n<g.NodeCount(); n++)
+    size_t e=0;
+    for(n=0; n<(node_id)g.NodeCount(); n++)
+      e+=g.OutEdgeCount(n);
+    Reserve(g.NodeCount(), e);
+
+    for(n=0; n<(node_id)g.NodeCount(); n++)
+      InsertNode(g.GetNodeAttr(n));
+    for(n=0; n<(node_id)g.NodeCount(); n++)
       { for(i=0; i<g.OutEdgeCount(n); i++)
           { void *attr; 
             node_id n2=g.GetOutEdge(n, i, &attr);
@@ -58,16 +74,18 @@ ARGEdit:: ARGEdit(ARGraph_impl &g)
  * Constructor
  ---------------------------------------------------------*/
 ARGEdit:: ARGEdit(ARGLoader &g) 
-  { count=0;
-    nodes=NULL;
-    lastNode=NULL;
-    lastEdge=NULL;
+  { Init();
 
     node_id n;
-    for(n=0; n<g.NodeCount(); n++)
-      InsertNode(g.GetNodeAttr(n));
     int i;
-    for(n=0; n<g.NodeCount(); n++)
+    size_t e=0;
+    for(n=0; n<(node_id)g.NodeCount(); n++)
+      e+=g.OutEdgeCount(n);
+    Reserve(g.NodeCount(), e);
+
+    for(n=0; n<(node_id)g.NodeCount(); n++)
+      InsertNode(g.GetNodeAttr(n));
+    for(n=0; n<(node_id)g.NodeCount(); n++)
       { for(i=0; i<g.OutEdgeCount(n); i++)
           { void *attr; 
             node_id n2=g.GetOutEdge(n, i, &attr);
@@ -81,25 +99,50 @@ ARGEdit:: ARGEdit(ARGLoader &g)
  * Destructor
  ---------------------------------------------------------*/
 ARGEdit::~ARGEdit()
-  { nNode *pn, *pn1;
-    eNode *pe, *pe1;
-
-    pn=nodes;
-    while (pn!=NULL)
-      { pe=pn->edges;
-        while (pe!=NULL)
-          { pe1=pe;
-            pe=pe->next;
-            destroyEdgeAttr(pe1->attr);
-            delete pe1;
-          }
-        pn1=pn;
-        pn=pn->next;
-        destroyNodeAttr(pn1->attr);
-        delete pn1;
-      }
+  { size_t e;
+    int i;
+    for(e=0; e<edge_count; e++)
+      if (edges[e].from!=NULL_NODE)
+        destroyEdgeAttr(edges[e].attr);
+    for(i=0; i<count; i++)
+      destroyNodeAttr(node_attr[i]);
+
+    delete[] node_attr;
+    delete[] out_count;
+    delete[] first;
+    delete[] edges;
   }
 
+/*----------------------------------------------------------
+ * Initializes an empty ARGEdit
+ ---------------------------------------------------------*/
+void ARGEdit::Init()
+  { count=node_cap=0;
+    node_attr=NULL;
+    out_count=NULL;
+    first=NULL;
+    edges=NULL;
+    edge_count=edge_cap=0;
+    sorted=true;
+  }
+
+/*----------------------------------------------------------
+ * Enlarges the vectors so that they can hold at least
+ * the given number of nodes and edges
+ ---------------------------------------------------------*/
+void ARGEdit::Reserve(int nodes, size_t nedges)
+  { if (nodes>node_cap)
+      { resize(node_attr, count, nodes);
+        resize(out_count, count, nodes);
+        resize(first, (sorted && first!=NULL)? count+1: 0, nodes+1);
+        first[0]=0;
+        node_cap=nodes;
+      }
+    if (nedges>edge_cap)
+      { resize(edges, edge_count, nedges);
+        edge_cap=nedges;
+      }
+  }
 
 /*------------------------------------------------------
  * Returns the number of nodes
@@ -112,32 +155,18 @@ int ARGEdit::NodeCount()
  * Returns the attr of a node.
  ----------------------------------------------------*/
 void* ARGEdit::GetNodeAttr(node_id id)
-  { nNode *n=nodes;
-
-    if (lastNode!=NULL && lastNode->id <= id)
-      n=lastNode;
-    
-    while (n!=NULL && n->id!=id)
-      n=n->next;
-    if (n==NULL)
+  { if (id>=(node_id)count)
       error("Inconsistent data");
-    return n->attr;
+    return node_attr[id];
   }
 
 /*------------------------------------------------------
  * Returns the number of edges coming out of a node.
  ----------------------------------------------------*/
 int ARGEdit::OutEdgeCount(node_id id)
-  { nNode *n=nodes;
-
-    if (lastNode!=NULL && lastNode->id <= id)
-      n=lastNode;
-    
-    while (n!=NULL && n->id!=id)
-      n=n->next;
-    if (n==NULL)
+  { if (id>=(node_id)count)
       error("Inconsistent data");
-    return n->count;
+    return out_count[id];
   }
 
 /*------------------------------------------------------
@@ -145,42 +174,37 @@ int ARGEdit::OutEdgeCount(node_id id)
  ----------------------------------------------------*/
 node_id ARGEdit::
 GetOutEdge(node_id id, int i, void **pattr)
-  { nNode *n=nodes;
-
-    if (lastNode!=NULL && lastNode->id <= id)
-      n=lastNode;
-    
-    while (n!=NULL && n->id!=id)
-      n=n->next;
-    if (n==NULL)
-      error("Inconsistent data");
-
-    eNode *e=n->edges;
-    int pos=0;
-
-    if (lastEdge!=NULL && lastEdge->from==id && 
-        lastEdge->pos>=0 && lastEdge->pos<=i)
-      { e=lastEdge;
-        pos=e->pos;
-      }
-
-    while (e!=NULL && pos<i)
-      { e->pos=pos;
-        e=e->next;
-        pos++;
-      }
-
-    if (e==NULL)
+  { if (id>=(node_id)count || i<0 || i>=out_count[id])
       error("Inconsistent data");
+    if (!sorted)
+      Sort();
 
+    eNode *e=edges+first[id]+i;
     if (pattr!=NULL)
       *pattr = e->attr;
-    lastNode = n;
-    lastEdge = e;
 
     return e->to;
   }
 
+/*------------------------------------------------------
+ * Copies all the edges of a node
+ ----------------------------------------------------*/
+void ARGEdit::
+GetOutEdges(node_id id, node_id *dest, void **attrs)
+  { if (id>=(node_id)count)
+      error("Inconsistent data");
+    if (!sorted)
+      Sort();
+
+    eNode *e=edges+first[id];
+    int i, k=out_count[id];
+    for(i=0; i<k; i++)
+      dest[i]=e[i].to;
+    if (attrs!=NULL)
+      for(i=0; i<k; i++)
+        attrs[i]=e[i].attr;
+  }
+
 
 
 
@@ -188,36 +212,17 @@ GetOutEdge(node_id id, int i, void **pattr)
  * Creates a new node
  ------------------------------------------*/
 node_id ARGEdit::InsertNode(void* attr)
-  { nNode *n=new nNode;
-    if (n==NULL)
-      error("Out of memory");
-    node_id id=n->id=count++;
-    n->attr=attr;
-    n->edges=NULL;
-    n->count=0;
-
-    nNode *p=nodes, *p0=NULL;
-    if (lastNode!=NULL && lastNode->id<id)
-      { p0=lastNode;
-        p=lastNode->next;
-      }
-    while(p!=NULL && p->id<id) 
-      { p0=p; 
-        p=p->next;
-      }
-
-
-    if (p0==NULL)
-      { n->next=nodes;
-        nodes=n;
-      }
-    else
-      { n->next=p0->next;
-        p0->next=n;
-      }
-    lastNode=n;
-
-     return n->id;
+  { if ((node_id)count>=NULL_NODE)
+      error("Too many nodes in ARGEdit::InsertNode");
+    if (count==node_cap)
+      Reserve(node_cap<16? 16: 2*node_cap, edge_cap);
+
+    node_id id=count++;
+    node_attr[id]=attr;
+    out_count[id]=0;
+    if (sorted)
+      first[id+1]=first[id];
+    return id;
   }
 
 
@@ -227,47 +232,82 @@ node_id ARGEdit::InsertNode(void* attr)
  ------------------------------------------*/
 void ARGEdit::InsertEdge(node_id id1, node_id id2, void* attr)
   {
-    eNode *e=new eNode;
-    if (e==NULL)
-      error("Out of memory");
+    if (id1>=(node_id)count)
+      error("Bad param 1 in ARGEdit::InsertEdge: %d", (int)id1);
+    if (id2>=(node_id)count)
+      error("Bad param 2 in ARGEdit::InsertEdge: %d", (int)id2);
+    if (edge_count==edge_cap)
+      Reserve(node_cap, edge_cap<16? 16: 2*edge_cap);
+
+    eNode *e=edges+edge_count++;
     e->from=id1;
     e->to=id2;
     e->attr=attr;
-    e->pos=-1;
-    nNode *pn=nodes;
-    if (lastNode!=NULL && lastNode->id<=id1)
-      { pn=lastNode;
-      }
-    while(pn!=NULL && pn->id<id1) 
-      { pn=pn->next;
-      }
-    if (pn==NULL || pn->id!=id1)
-      error("Bad param 1 in ARGEdit::InsertEdge: %d", (int)id1);
+    out_count[id1]++;
+    sorted=false;
+  }
 
-    eNode *p=pn->edges, *p0=NULL;
-    if (lastEdge!=NULL && lastEdge->from==id1 && lastEdge->to<id2)
-      { p0=lastEdge;
-        p=lastEdge->next;
-      }
-    while (p!=NULL && p->to<id2)
-      { p0=p;
-        p=p->next;
-      }
-    if (p!=NULL && p->to==id2)
-      error("Bad param 2 in ARGEdit::InsertEdge: %d", (int)id2);
+/*-------------------------------------------------------------
+ * Sorts the edges by source and destination, removing the
+ * deleted ones, and computes the position of the first edge
+ * of each node.
+ * The edges are sorted by destination and then (stably) by
+ * source, using a counting sort for each pass; if the edges
+ * are already in order (e.g. they were given by a loader
+ * reading a file), the sorting is skipped.
+ * It is an error if the same edge has been inserted twice.
+ ------------------------------------------------------------*/
+void ARGEdit::Sort()
+  { size_t e, live=0;
+    bool in_order=true;
+    int i;
 
-    if (p0==NULL)
-      { e->next=pn->edges;
-        pn->edges=e;
+    for(e=0; e<edge_count; e++)
+      { if (edges[e].from==NULL_NODE)
+          continue;
+        if (live>0 && 
+            (edges[live-1].from>edges[e].from ||
+             (edges[live-1].from==edges[e].from && 
+              edges[live-1].to>=edges[e].to)))
+          in_order=false;
+        edges[live++]=edges[e];
       }
-    else
-      { e->next=p0->next;
-        p0->next=e;
+    edge_count=live;
+
+    first[0]=0;
+    for(i=0; i<count; i++)
+      first[i+1]=first[i]+out_count[i];
+    assert(first[count]==live);
+
+    if (!in_order)
+      { eNode *tmp=new eNode[live];
+        size_t *pos=new size_t[count+1];
+        if (tmp==NULL || pos==NULL)
+          OUT_OF_MEMORY();
+
+        memset(pos, 0, (count+1)*sizeof(size_t));
+        for(e=0; e<live; e++)
+          pos[edges[e].to+1]++;
+        for(i=0; i<count; i++)
+          pos[i+1]+=pos[i];
+        for(e=0; e<live; e++)
+          tmp[pos[edges[e].to]++]=edges[e];
+
+        memcpy(pos, first, (count+1)*sizeof(size_t));
+        for(e=0; e<live; e++)
+          edges[pos[tmp[e].from]++]=tmp[e];
+
+        delete[] tmp;
+        delete[] pos;
+
+        for(e=1; e<live; e++)
+          if (edges[e].from==edges[e-1].from && edges[e].to==edges[e-1].to)
+            error("Duplicate edge in ARGEdit::InsertEdge: (%d, %d)",
+                  (int)edges[e].from, (int)edges[e].to);
       }
-    pn->count++;
-    lastNode=pn;
-    lastEdge=e;
-}
+
+    sorted=true;
+  }
 
 
 
@@ -275,110 +315,79 @@ void ARGEdit::InsertEdge(node_id id1, node_id id2, void* attr)
  * Delete a node
  --------------------------------------------------*/
 void ARGEdit::DeleteNode(node_id id)
-  { nNode *p=nodes, *p0=NULL;
-
-    if (lastNode!=NULL && lastNode->id<id)
-      { p0=lastNode;
-        p=lastNode->next;
-      }
-    while(p!=NULL && p->id<id) 
-      { p0=p; 
-        p=p->next;
-      }
-
-    if (p==NULL || !p->id==id)
+  { if (id>=(node_id)count)
       error("Bad param in ARGEdit::DeleteNode");
 
-    while (p->edges != NULL)
-      { eNode *ep=p->edges;
-        p->edges=ep->next;
-        destroyEdgeAttr(ep->attr);
-        delete ep;
-      }
-    lastEdge=NULL;
-    destroyNodeAttr(p->attr);
-    if (p0==NULL)
-      { nodes=p->next;
-      }
-    else
-      { p0->next=p->next;
-      }
-    delete p;
-    count--;
-
-    p=nodes;
-    while (p!=NULL)
-      { if (p->id > id)
-          p->id --;
-        eNode *ep0=NULL;
-        eNode *ep=p->edges;
-        while (ep!=NULL)
-          { if (ep->to == id)
-              { if (ep0==NULL)
-                  p->edges=ep->next;
-                else
-                  ep0->next=ep->next;
-                destroyEdgeAttr(ep->attr);
-                delete ep;
-		p->count--;
-                if (ep0==NULL)
-                  ep=p->edges;
-                else
-                  ep=ep0->next;
-                continue;
-              }
-            if (ep->from > id)
-              ep->from --;
-            if (ep->to > id)
-              ep->to --;
-            ep0=ep;
-            ep=ep->next;
+    size_t e;
+    for(e=0; e<edge_count; e++)
+      { eNode *p=edges+e;
+        if (p->from==NULL_NODE)
+          continue;
+        if (p->from==id || p->to==id)
+          { destroyEdgeAttr(p->attr);
+            out_count[p->from]--;
+            p->from=NULL_NODE;
+            continue;
           }
-        p=p->next;
+        if (p->from > id)
+          p->from --;
+        if (p->to > id)
+          p->to --;
       }
-    
 
-    lastNode=p0;
+    destroyNodeAttr(node_attr[id]);
+    count--;
+    memmove(node_attr+id, node_attr+id+1, (count-id)*sizeof(void*));
+    memmove(out_count+id, out_count+id+1, (count-id)*sizeof(int));
+    sorted=false;
   }
 
 /*------------------------------------
  * Delete an edge
  -----------------------------------*/
 void ARGEdit::DeleteEdge(node_id id1, node_id id2)
-  { nNode *pn=nodes;
-
-    if (lastNode!=NULL && lastNode->id<=id1)
-      pn=lastNode;
-
-    while (pn!=NULL && pn->id < id1)
-      pn=pn->next;
-
-    if (pn==NULL || pn->id != id1)
+  { if (id1>=(node_id)count)
       error("Bad param in ARGEdit::DeleteEdge");
-
-    eNode *pe=pn->edges, *pe0=NULL;
-
-    if (lastEdge!=NULL &&  lastEdge->from==id1 && lastEdge->to < id2)
-      { pe0=lastEdge;
-        pe=pe0->next;
+    if (!sorted)
+      Sort();
+
+    eNode *list=edges+first[id1];
+    int a=0, b=out_count[id1];
+    while (a<b)
+      { int m=(a+b)/2;
+        if (list[m].to<id2)
+          a=m+1;
+        else
+          b=m;
       }
-
-    while (pe!=NULL && pe->to<id2)
-      { pe0=pe;
-        pe=pe->next;
-      }
-    
-    if (pe==NULL || pe->to != id2)
+    if (a==out_count[id1] || list[a].to!=id2)
       error("Bad param in ARGEdit::DeleteEdge");
 
-    if (pe0==NULL)
-      pn->edges=pe->next;
-    else
-      pe0->next=pe->next;
-    destroyEdgeAttr(pe->attr);
-    delete pe;
-    pn->count--;
+    destroyEdgeAttr(list[a].attr);
+    int last=--out_count[id1];
+    memmove(list+a, list+a+1, (last-a)*sizeof(eNode));
+    list[last].from=NULL_NODE;  // Removed by the next Sort
+  }
 
-    lastNode=pn;
-    lastEdge=pe0;
+/*------------------------------------------------------------
+ * Returns the heap memory used by the ARGEdit (in bytes),
+ * not counting the attributes
+ -----------------------------------------------------------*/
+size_t ARGEdit::MemoryUsage()
+  { size_t size=sizeof(ARGEdit) + edge_cap*sizeof(eNode);
+    if (node_cap>0)
+      size+=node_cap*(sizeof(void*)+sizeof(int)) + 
+            (node_cap+1)*sizeof(size_t);
+    return size;
+  }
+
+/*------------------------------------------------------------
+ * Estimates the memory used by an ARGEdit holding the given
+ * number of nodes and edges; since the vectors grow by
+ * doubling their size, an ARGEdit built by InsertNode and
+ * InsertEdge can use up to twice as much
+ -----------------------------------------------------------*/
+size_t ARGEdit::EstimateMemoryUsage(int nodes, size_t edges)
+  { return sizeof(ARGEdit) + edges*sizeof(eNode) +
+           nodes*(sizeof(void*)+sizeof(int)) + (nodes+1)*sizeof(size_t);
   }
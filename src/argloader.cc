@@ -59,10 +59,220 @@
  *     02 00     Target of the second edge of node 1 (edge 1 -> 2)
  *     01 00     Number of edges out of node 2 (1)
  *     00 00     Target of the first (and only) edge of node 2 (edge 2 -> 0)
+ * Since the words are 16 bits wide, graphs with more than 65535 nodes
+ * (allowed when the library is compiled with VF_LARGE_GRAPHS) cannot
+ * be stored in this format.
  -----------------------------------------------------------------------------*/
 
 
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <errno.h>
+
 #include "argloader.h"
+#include "error.h"
+
+
+
+/*------------------------------------------------------------------
+ * Methods of the class TextReader
+ -----------------------------------------------------------------*/
+
+/*------------------------------------------------------------------
+ * Constructor
+ -----------------------------------------------------------------*/
+TextReader::TextReader(istream &in)
+  : in(in), field_in(&buf)
+  { size=256;
+    line=new char[size];
+    if (line==NULL)
+      OUT_OF_MEMORY();
+    *line='\0';
+    pos=line_end=line;
+  }
+
+TextReader::~TextReader()
+  { delete[] line;
+  }
+
+/*------------------------------------------------------------------
+ * Reads the next line of the stream, whatever its length;
+ * returns false at the end of the stream
+ -----------------------------------------------------------------*/
+bool TextReader::GetLine()
+  { size_t len=0;
+
+    for(;;)
+      { in.getline(line+len, size-len);
+        size_t got=in.gcount();
+        if (in.fail() && !in.eof() && got==size-len-1)
+          { // The line does not fit in the buffer
+            char *new_line=new char[2*size];
+            if (new_line==NULL)
+              OUT_OF_MEMORY();
+            len+=got;
+            memcpy(new_line, line, len);
+            delete[] line;
+            line=new_line;
+            size*=2;
+            in.clear();
+            continue;
+          }
+        if (in.fail())
+          { if (len==0 && got==0)
+              { *line='\0';
+                pos=line_end=line;
+                return false;
+              }
+            in.clear(ios::eofbit);
+          }
+        if (got>0 && !in.eof())
+          got--;                  // The newline is not stored
+        len+=got;
+        break;
+      }
+
+    pos=line;
+    line_end=line+len;
+    return true;
+  }
+
+/*------------------------------------------------------------------
+ * Reads the next line that is not blank and is not a comment
+ * (i.e. does not start with #). It is an error if there
+ * are no more lines
+ -----------------------------------------------------------------*/
+void TextReader::NextLine()
+  { for(;;)
+      { if (!GetLine())
+          error("End of file or reading error");
+        while (isspace((unsigned char)*pos))
+          pos++;
+        if (*pos!='\0' && *pos!='#')
+          return;
+      }
+  }
+
+/*------------------------------------------------------------------
+ * Reads an integer field; returns false if there is no
+ * field or it is not a valid long
+ -----------------------------------------------------------------*/
+bool TextReader::ReadLong(long &value)
+  { char *p=pos;
+    while (isspace((unsigned char)*p))
+      p++;
+    bool neg=(*p=='-');
+    if (*p=='-' || *p=='+')
+      p++;
+    if (!isdigit((unsigned char)*p))
+      return false;
+
+    unsigned long x=0, limit=neg? -(unsigned long)LONG_MIN: LONG_MAX;
+    do
+      { unsigned d=*p++ - '0';
+        if (x>(limit-d)/10)
+          return false;
+        x=x*10+d;
+      } while (isdigit((unsigned char)*p));
+
+    value=neg? -(long)(x-1)-1: (long)x;
+    pos=p;
+    return true;
+  }
+
+/*------------------------------------------------------------------
+ * Reads a non negative integer field
+ -----------------------------------------------------------------*/
+bool TextReader::ReadUnsigned(unsigned long &value)
+  { char *p=pos;
+    while (isspace((unsigned char)*p))
+      p++;
+    if (*p=='+')
+      p++;
+    if (!isdigit((unsigned char)*p))
+      return false;
+
+    unsigned long x=0;
+    do
+      { unsigned d=*p++ - '0';
+        if (x>(ULONG_MAX-d)/10)
+          return false;
+        x=x*10+d;
+      } while (isdigit((unsigned char)*p));
+
+    value=x;
+    pos=p;
+    return true;
+  }
+
+bool TextReader::Read(long &value)
+  { return ReadLong(value);
+  }
+
+bool TextReader::Read(int &value)
+  { long x;
+    if (!ReadLong(x) || x<INT_MIN || x>INT_MAX)
+      return false;
+    value=x;
+    return true;
+  }
+
+bool TextReader::Read(short &value)
+  { long x;
+    if (!ReadLong(x) || x<SHRT_MIN || x>SHRT_MAX)
+      return false;
+    value=x;
+    return true;
+  }
+
+bool TextReader::Read(unsigned long &value)
+  { return ReadUnsigned(value);
+  }
+
+bool TextReader::Read(unsigned &value)
+  { unsigned long x;
+    if (!ReadUnsigned(x) || x>UINT_MAX)
+      return false;
+    value=x;
+    return true;
+  }
+
+bool TextReader::Read(unsigned short &value)
+  { unsigned long x;
+    if (!ReadUnsigned(x) || x>USHRT_MAX)
+      return false;
+    value=x;
+    return true;
+  }
+
+/*------------------------------------------------------------------
+ * Reads a floating point field
+ -----------------------------------------------------------------*/
+bool TextReader::Read(double &value)
+  { char *end;
+    errno=0;
+    double x=strtod(pos, &end);
+    if (end==pos || errno==ERANGE)
+      return false;
+    value=x;
+    pos=end;
+    return true;
+  }
+
+bool TextReader::Read(float &value)
+  { double x;
+    if (!Read(x))
+      return false;
+    value=(float)x;
+    return true;
+  }
+
+
+
+/*------------------------------------------------------------------
+ * Methods of the class BinaryGraphLoader
+ -----------------------------------------------------------------*/
 
 
 
@@ -115,6 +325,8 @@ unsigned BinaryGraphLoader::readWord(istream& in)
 void BinaryGraphLoader::writeWord(ostream& out, unsigned w)
   { unsigned char c1, c2;
 
+    if (w > 0xFFFF)
+      error("BinaryGraphLoader::write: value %u does not fit in 16 bits", w);
     c1 = w & 0xFF; 
     c2 = w >> 8;
     out << c1 << c2;
@@ -9,6 +9,10 @@
 #include <string.h>
 #include <stddef.h>
 
+#ifndef VF_NO_THREADS
+#include <thread>
+#endif
+
 #include "argraph.h"
 #include "error.h"
 
@@ -43,70 +47,180 @@ inline void clear(byte *ptr, int n)
  --------------------------------------------------------------*/
 static void ptrcheck(void *);
 
+/*---------------------------------------------------------------
+ * Hash function and table size for the hub tables
+ --------------------------------------------------------------*/
+inline unsigned hub_hash(unsigned x)
+  { x ^= x >> 16;
+    x *= 0x45d9f3bu;
+    x ^= x >> 16;
+    return x;
+  }
+
+/*---------------------------------------------------------------
+ * Size of a vector of attributes stored by value, rounded so
+ * that the next vector in the storage block is still aligned
+ --------------------------------------------------------------*/
+inline size_t value_block_size(size_t bytes)
+  { return (bytes+15) & ~(size_t)15;
+  }
+
+/*--------------------------------------------------------------
+ * The bit of a node signature corresponding to a neighbor
+ * with the given label, reached thru an 'out' (dir=0) or
+ * 'in' (dir=1) edge
+ --------------------------------------------------------------*/
+inline ARGraph_impl::signature_type label_bit(int label, int dir)
+  { const unsigned bits=ARGraph_impl::SIG_LABEL_BITS;
+    unsigned h=((unsigned)label*2+dir)*2654435761u;
+    return (ARGraph_impl::signature_type)1 << (64-bits + (h>>16)%bits);
+  }
+
+template <class T>
+inline T hub_table_size(T deg)
+  { T size=1;
+    while (size<2*deg)
+      size<<=1;
+    return size;
+  }
+
+/*----------------------------------------------------------------
+ * methods of the class ARGLoader
+ ---------------------------------------------------------------*/
+
+/*---------------------------------------------------------------
+ * Copies the OutEdgeCount(node) edges of a node into dest,
+ * and their attributes into attrs (if not NULL).
+ * This version calls GetOutEdge for each edge; a loader
+ * holding the edges of a node in a vector should redefine it.
+ --------------------------------------------------------------*/
+void ARGLoader::GetOutEdges(node_id node, node_id *dest, void **attrs)
+  { int i, k=OutEdgeCount(node);
+    for(i=0; i<k; i++)
+      dest[i]=GetOutEdge(node, i, (attrs==NULL)? NULL: &attrs[i]);
+  }
+
+
 /*----------------------------------------------------------------
  * methods of the class ARGraph_impl
  ---------------------------------------------------------------*/
 
 /*---------------------------------------------------------------
  * Constructor
+ * If node_size (edge_size) is not 0, the node (edge) attributes
+ * are stored by value, copying node_size (edge_size) bytes from 
+ * the attributes provided by the loader.
+ * If undirected is true, each edge given by the loader connects
+ * its ends in both directions (see MakeUndirected); an edge may
+ * also be given in both directions, and is then kept once. With
+ * attributes stored by pointer, the attribute that is not kept
+ * is still owned by the graph, and destroyed with it.
  --------------------------------------------------------------*/
-ARGraph_impl::ARGraph_impl(ARGLoader *loader)
-  { node_destroyer=NULL;
-    edge_destroyer=NULL;
-    node_comparator=NULL;
-    edge_comparator=NULL;
+ARGraph_impl::ARGraph_impl(ARGLoader *loader, size_t node_size,
+                           size_t edge_size, bool undirected)
+  { InitEmpty();
+    this->node_size=node_size;
+    this->edge_size=edge_size;
     n = loader->NodeCount();
-    attr = new void*[n];
-    ptrcheck(attr);
-    int i, j;
+
+    int i, j, k, max_deg=0;
+    offset_type edges=0;
     for(i=0; i<n; i++)
-      attr[i]=loader->GetNodeAttr(i);
-    in_count=new count_type[n];
-    ptrcheck(in_count);
-    clear(in_count, n);
-    out_count=new count_type[n];
-    ptrcheck(out_count);
-    clear(out_count, n);
-    in=new node_id*[n];
-    ptrcheck(in);
-    clear(in, n);
-    out=new node_id*[n];
-    ptrcheck(out);
-    clear(out, n);
-    in_attr=new void**[n];
-    ptrcheck(in_attr);
-    clear(in_attr, n);
-    out_attr=new void**[n];
-    ptrcheck(out_attr);
-    clear(out_attr, n);
+      { k=loader->OutEdgeCount(i);
+        edges+=k;
+        if (k>max_deg)
+          max_deg=k;
+      }
+
+    AllocStorage(edges);
+
     for(i=0; i<n; i++)
-      { int k=out_count[i]=loader->OutEdgeCount(i);
-        out[i]=new node_id[k];
-        ptrcheck(out[i]);
-        out_attr[i]=new void *[k];
-        ptrcheck(out_attr[i]);
-        for(j=0; j<k; j++)
-          { node_id n2=out[i][j]=loader->GetOutEdge(i, j, &out_attr[i][j]);
-            in_count[n2]++;
-          }
+      { if (node_values!=NULL)
+          StoreValue(node_values+i*node_size, loader->GetNodeAttr(i), 
+                     node_size);
+        else
+          attr[i]=loader->GetNodeAttr(i);
       }
-    
+
+    // The edges of each node are copied by a single call; the
+    // attributes stored by value pass through a temporary vector
+    void **eattr=NULL;
+    if (edge_values!=NULL && max_deg>0)
+      { eattr=new void*[max_deg];
+        if (eattr==NULL)
+          OUT_OF_MEMORY();
+      }
+
+    offset_type pos=0;
     for(i=0; i<n; i++)
-      { int k=in_count[i];
-        in[i]=new node_id[k];
-        ptrcheck(in[i]);
-        in_attr[i]=new void *[k];
-        ptrcheck(in_attr[i]);
-        int l=0;
-        for(j=0; j<n; j++)
-          { if (HasEdge(j,i))
-              { in[i][l]=j;
-                in_attr[i][l]=GetEdgeAttr(j, i);
-                l++;
-              }
+      { k=loader->OutEdgeCount(i);
+        out_start[i]=pos;
+        if (k>max_deg || pos+k>edges)
+          error("ARGraph_impl: inconsistent edge count from the loader");
+        if (edge_values!=NULL)
+          { loader->GetOutEdges(i, out+pos, eattr);
+            for(j=0; j<k; j++)
+              StoreValue(edge_values+(pos+j)*edge_size, eattr[j],
+                         edge_size);
           }
-        assert(l==k);
+        else
+          loader->GetOutEdges(i, out+pos, out_attr+pos);
+        pos+=k;
       }
+    delete[] eattr;
+    out_start[n]=pos;
+    if (pos!=edges)
+      error("ARGraph_impl: inconsistent edge count from the loader");
+    out_end=out_start+1;
+    in_end=in_start+1;
+    edge_count=edge_slots=edges;
+
+    BuildInEdges();
+    if (undirected)
+      MakeUndirected();
+    BuildHubTables();
+  }
+
+/*---------------------------------------------------------------
+ * Constructor for the derived classes which manage the
+ * vectors on their own: builds a graph with no nodes.
+ --------------------------------------------------------------*/
+ARGraph_impl::ARGraph_impl()
+  { InitEmpty();
+  }
+
+/*---------------------------------------------------------------
+ * Initializes the members for an empty graph, with no vectors
+ --------------------------------------------------------------*/
+void ARGraph_impl::InitEmpty()
+  { n=0;
+    node_size=edge_size=0;
+    storage=NULL;
+    undirected=false;
+    dup_attr=NULL;
+    dup_count=0;
+    node_values=edge_values=NULL;
+    attr=NULL;
+    in_start=in_end=out_start=out_end=in_pos=NULL;
+    in=out=NULL;
+    in_attr=out_attr=NULL;
+    edge_count=edge_slots=0;
+    node_destroyer=NULL;
+    edge_destroyer=NULL;
+    node_comparator=NULL;
+    edge_comparator=NULL;
+    adj_matrix=NULL;
+    adj_stride=0;
+    hub_count=0;
+    hub_node=NULL;
+    hub_start=NULL;
+    hub_slot=NULL;
+    orig_id=NULL;
+    new_id=NULL;
+    signature=NULL;
+    node_label=NULL;
+    edge_label=NULL;
+    in_label=NULL;
   }
 
 /*-------------------------------------------------
@@ -115,27 +229,32 @@ ARGraph_impl::ARGraph_impl(ARGLoader *loader)
  * Frees the memory allocated for the graph
  ------------------------------------------------*/
 ARGraph_impl::~ARGraph_impl()
-  { int i,j;
-    for(i=0; i<n; i++)
-      { 
-        for(j=0; j<out_count[i]; j++)
-            DestroyEdge(out_attr[i][j]);
-        delete[] in[i];
-        delete[] in_attr[i];
-        delete[] out[i];
-        delete[] out_attr[i];
-      }
+  { offset_type e;
+    int i;
+    if (edge_destroyer!=NULL && edge_values==NULL)
+      for(i=0; i<n; i++)
+        for(e=out_start[i]; e<out_end[i]; e++)
+          if (!undirected || out[e]>=(node_id)i)   // Each undirected edge once
+            DestroyEdge(out_attr[e]);
+    if (edge_destroyer!=NULL)
+      for(e=0; e<dup_count; e++)
+        DestroyEdge(dup_attr[e]);
+    delete[] dup_attr;
 
-    for(i=0; i<n; i++)
-      DestroyNode(attr[i]);
+    if (node_destroyer!=NULL && node_values==NULL)
+      for(i=0; i<n; i++)
+        DestroyNode(attr[i]);
 
-    delete[] attr;
-    delete[] in_attr;
-    delete[] out_attr;
-    delete[] in_count;
-    delete[] in;
-    delete[] out_count;
-    delete[] out;
+    delete[] storage;
+    delete[] adj_matrix;
+    delete[] hub_node;
+    delete[] hub_start;
+    delete[] hub_slot;
+    delete[] orig_id;
+    delete[] new_id;
+    delete[] node_label;
+    delete[] edge_label;  // in_label is in the same block
+    delete[] signature;
     
     delete node_destroyer;
     delete edge_destroyer;
@@ -143,6 +262,630 @@ ARGraph_impl::~ARGraph_impl()
     delete edge_comparator;
   }
 
+/*-------------------------------------------------------------------
+ * Allocates the block containing the vectors of the graph,
+ * for n nodes and the given number of edges, and sets the
+ * pointers to the vectors. The vectors are placed in order
+ * of decreasing alignment, so that each one is properly aligned;
+ * the attributes stored by value come first, each vector rounded
+ * to a multiple of 16 bytes.
+ * The vectors not needed by the chosen attribute storage are 
+ * set to NULL. For an undirected graph the 'in' vectors are not
+ * allocated, and are made aliases of the 'out' vectors.
+ ------------------------------------------------------------------*/
+void ARGraph_impl::AllocStorage(offset_type edges)
+  { size_t size=StorageSize(n, edges, node_size, edge_size, undirected);
+    storage=new char[size];
+    ptrcheck(storage);
+    SetStorage(storage, edges);
+  }
+
+/*-------------------------------------------------------------------
+ * Sets the pointers to the vectors of the graph, carving them
+ * from a block laid out as described in AllocStorage, for n
+ * nodes and the given number of edges.
+ * The block is not owned by the graph unless it is 'storage'
+ * (see MappedGraph).
+ ------------------------------------------------------------------*/
+void ARGraph_impl::SetStorage(char *block, offset_type edges)
+  { size_t sides=undirected? 1: 2;
+    size_t nodes_by_ptr=(node_size==0)? n: 0;
+    size_t edges_by_ptr=(edge_size==0)? edges: 0;
+    size_t edges_by_val=(edge_size==0 || undirected)? 0: edges;
+
+    char *p=block;
+    node_values=(node_size>0)? p: NULL;
+                                p+=value_block_size(n*node_size);
+    edge_values=(edge_size>0)? p: NULL;
+                                p+=value_block_size(edges*edge_size);
+    attr=(void**)p;             p+=nodes_by_ptr*sizeof(void*);
+    out_attr=(void**)p;         p+=edges_by_ptr*sizeof(void*);
+    in_attr=(void**)p;          p+=(sides-1)*edges_by_ptr*sizeof(void*);
+    out_start=(offset_type*)p;  p+=(n+1)*sizeof(offset_type);
+    in_start=(offset_type*)p;   p+=(sides-1)*(n+1)*sizeof(offset_type);
+    in_pos=(offset_type*)p;     p+=edges_by_val*sizeof(offset_type);
+    out=(node_id*)p;            p+=edges*sizeof(node_id);
+    in=(node_id*)p;             p+=(sides-1)*edges*sizeof(node_id);
+    assert(p==block+StorageSize(n, edges, node_size, edge_size, 
+                                undirected));
+
+    if (undirected)
+      { in_attr=out_attr;
+        in_start=out_start;
+        in=out;
+      }
+    if (node_size>0)
+      attr=NULL;
+    if (edge_size>0)
+      out_attr=in_attr=NULL;
+    if (edge_size==0 || undirected)
+      in_pos=NULL;
+  }
+
+/*---------------------------------------------------------------
+ * Size of the storage block of a graph with n nodes and the
+ * given number of entries in the 'out' vectors
+ --------------------------------------------------------------*/
+size_t ARGraph_impl::StorageSize(int n, size_t edges, size_t node_size,
+                                 size_t edge_size, bool undirected)
+  { size_t sides=undirected? 1: 2;
+    size_t nodes_by_ptr=(node_size==0)? n: 0;
+    size_t edges_by_ptr=(edge_size==0)? edges: 0;
+    size_t edges_by_val=(edge_size==0 || undirected)? 0: edges;
+    return value_block_size(n*node_size) +
+           value_block_size(edges*edge_size) +
+           (nodes_by_ptr+sides*edges_by_ptr)*sizeof(void*) +
+           (sides*(n+1)+edges_by_val)*sizeof(offset_type) +
+           (sides*edges)*sizeof(node_id);
+  }
+
+/*-------------------------------------------------------------------
+ * Copies an attribute provided by the loader into the vector
+ * of the attributes stored by value. A NULL attribute is stored
+ * as a block of zeros.
+ ------------------------------------------------------------------*/
+void ARGraph_impl::StoreValue(char *dest, void *value, size_t size)
+  { if (value==NULL)
+      memset(dest, 0, size);
+    else
+      memcpy(dest, value, size);
+  }
+
+/*-------------------------------------------------------------------
+ * Computes the 'in' vectors (in_start, in, in_attr or in_pos) by 
+ * transposing
+ * the 'out' vectors, using a counting sort in O(n+E) time.
+ * Since the sources are scanned in increasing order, each 'in' list
+ * comes out sorted.
+ * For large graphs the work is split among several threads:
+ * each thread handles a range of source nodes, and has its own
+ * vector of counters, which is turned into a vector of insertion
+ * positions so that the threads never write the same element.
+ ------------------------------------------------------------------*/
+void ARGraph_impl::BuildInEdges()
+  { offset_type edges=out_start[n];
+
+#ifndef VF_NO_THREADS
+    int threads=1;
+    if (edges>=PARALLEL_BUILD_EDGES)
+      { threads=std::thread::hardware_concurrency();
+        if (threads>MAX_BUILD_THREADS)
+          threads=MAX_BUILD_THREADS;
+        if ((size_t)threads*n > 4*(size_t)edges)
+          threads=1;   // The counters would outweigh the edges
+      }
+    if (threads>1)
+      { BuildInEdgesParallel(threads);
+        return;
+      }
+#endif
+
+    int i;
+    offset_type e;
+    clear(in_start, n+1);
+    for(e=0; e<edges; e++)
+      in_start[out[e]+1]++;
+    for(i=0; i<n; i++)
+      in_start[i+1]+=in_start[i];
+
+    offset_type *pos=new offset_type[n];
+    ptrcheck(pos);
+    VCOPY(pos, in_start, offset_type, n);
+    for(i=0; i<n; i++)
+      for(e=out_start[i]; e<out_start[i+1]; e++)
+        { offset_type p=pos[out[e]]++;
+          in[p]=i;
+          if (in_pos!=NULL)
+            in_pos[p]=e;
+          else
+            in_attr[p]=out_attr[e];
+        }
+    delete[] pos;
+  }
+
+#ifndef VF_NO_THREADS
+/*-------------------------------------------------------------------
+ * Data and functions for the threads of BuildInEdgesParallel.
+ * Thread t works on the source nodes from first to last-1, and
+ * on the destination nodes from dfirst to dlast-1 (for the
+ * computation of the insertion positions).
+ ------------------------------------------------------------------*/
+struct ARGraph_impl::transpose_job
+  { ARGraph_impl *g;
+    int t, threads;
+    int first, last;
+    int dfirst, dlast;
+    offset_type *cnt;   // threads rows of n counters
+  };
+
+void ARGraph_impl::CountJob(transpose_job *job)
+  { ARGraph_impl *g=job->g;
+    offset_type *cnt=job->cnt + (size_t)job->t*g->n;
+    clear(cnt, g->n);
+    offset_type e;
+    for(e=g->out_start[job->first]; e<g->out_start[job->last]; e++)
+      cnt[g->out[e]]++;
+  }
+
+void ARGraph_impl::OffsetJob(transpose_job *job)
+  { ARGraph_impl *g=job->g;
+    int j, t;
+    for(j=job->dfirst; j<job->dlast; j++)
+      { offset_type p=g->in_start[j];
+        for(t=0; t<job->threads; t++)
+          { offset_type *c=job->cnt+(size_t)t*g->n+j;
+            offset_type tmp=*c;
+            *c=p;
+            p+=tmp;
+          }
+      }
+  }
+
+void ARGraph_impl::ScatterJob(transpose_job *job)
+  { ARGraph_impl *g=job->g;
+    offset_type *pos=job->cnt + (size_t)job->t*g->n;
+    int i;
+    offset_type e;
+    for(i=job->first; i<job->last; i++)
+      for(e=g->out_start[i]; e<g->out_start[i+1]; e++)
+        { offset_type p=pos[g->out[e]]++;
+          g->in[p]=i;
+          if (g->in_pos!=NULL)
+            g->in_pos[p]=e;
+          else
+            g->in_attr[p]=g->out_attr[e];
+        }
+  }
+
+/*-------------------------------------------------------------------
+ * Runs a job function on all the jobs, using a thread for each one
+ ------------------------------------------------------------------*/
+void ARGraph_impl::RunJobs(void (*fn)(transpose_job *), 
+                           transpose_job *jobs, int threads)
+  { std::thread *thr=new std::thread[threads];
+    int t;
+    for(t=0; t<threads; t++)
+      thr[t]=std::thread(fn, &jobs[t]);
+    for(t=0; t<threads; t++)
+      thr[t].join();
+    delete[] thr;
+  }
+
+/*-------------------------------------------------------------------
+ * Parallel version of BuildInEdges.
+ * The source nodes are split into ranges with roughly the same
+ * number of edges; the destination nodes into ranges with the
+ * same number of nodes.
+ ------------------------------------------------------------------*/
+void ARGraph_impl::BuildInEdgesParallel(int threads)
+  { offset_type edges=out_start[n];
+    transpose_job *jobs=new transpose_job[threads];
+    offset_type *cnt=new offset_type[(size_t)threads*n];
+    ptrcheck(jobs);
+    ptrcheck(cnt);
+
+    int t, i=0, j;
+    for(t=0; t<threads; t++)
+      { jobs[t].g=this;
+        jobs[t].t=t;
+        jobs[t].threads=threads;
+        jobs[t].cnt=cnt;
+        jobs[t].first=i;
+        offset_type limit=(offset_type)((double)edges*(t+1)/threads);
+        while (i<n && (t==threads-1 || out_start[i+1]<=limit))
+          i++;
+        jobs[t].last=i;
+        jobs[t].dfirst=(int)((double)n*t/threads);
+        jobs[t].dlast=(int)((double)n*(t+1)/threads);
+      }
+
+    RunJobs(CountJob, jobs, threads);
+
+    in_start[0]=0;
+    for(j=0; j<n; j++)
+      { offset_type deg=0;
+        for(t=0; t<threads; t++)
+          deg+=cnt[(size_t)t*n+j];
+        in_start[j+1]=in_start[j]+deg;
+      }
+
+    RunJobs(OffsetJob, jobs, threads);
+    RunJobs(ScatterJob, jobs, threads);
+
+    delete[] cnt;
+    delete[] jobs;
+  }
+#endif
+
+/*-------------------------------------------------------------------
+ * Turns a graph just built (with both the 'out' and the 'in' 
+ * vectors) into an undirected graph: the neighbors of each node
+ * are obtained by merging its 'out' and 'in' lists. A node
+ * connected in both directions is kept only once, with the
+ * attribute of the edge whose source has the lower id, so that
+ * both the ends see the same attribute. If the attributes are
+ * stored by pointer, the attribute of the other edge, when
+ * different, is kept in dup_attr, and is destroyed with the
+ * graph if an edge destroyer has been set.
+ * The vectors are moved into a new, smaller storage block.
+ ------------------------------------------------------------------*/
+void ARGraph_impl::MakeUndirected()
+  { int i;
+    offset_type a, b, ea, eb, entries=0, dups=0;
+
+    for(i=0; i<n; i++)
+      { a=out_start[i];
+        ea=out_start[i+1];
+        b=in_start[i];
+        eb=in_start[i+1];
+        while (a<ea || b<eb)
+          { if (b==eb || (a<ea && out[a]<in[b]))
+              a++;
+            else if (a==ea || in[b]<out[a])
+              b++;
+            else
+              { if (edge_values==NULL && (node_id)i<out[a] &&
+                    in_attr[b]!=NULL && in_attr[b]!=out_attr[a])
+                  dups++;
+                a++;
+                b++;
+              }
+            entries++;
+          }
+      }
+
+    assert(dup_attr==NULL);
+    if (dups>0)
+      { dup_attr=new void*[dups];
+        if (dup_attr==NULL)
+          OUT_OF_MEMORY();
+      }
+
+    char *old_storage=storage;
+    char *old_node_values=node_values;
+    char *old_edge_values=edge_values;
+    void* *old_attr=attr;
+    void* *old_out_attr=out_attr;
+    void* *old_in_attr=in_attr;
+    offset_type *old_out_start=out_start;
+    offset_type *old_in_start=in_start;
+    offset_type *old_in_pos=in_pos;
+    node_id *old_out=out;
+    node_id *old_in=in;
+
+    undirected=true;
+    AllocStorage(entries);
+    if (node_values!=NULL)
+      memcpy(node_values, old_node_values, n*node_size);
+    else
+      VCOPY(attr, old_attr, void*, n);
+
+    offset_type pos=0;
+    for(i=0; i<n; i++)
+      { a=old_out_start[i];
+        ea=old_out_start[i+1];
+        b=old_in_start[i];
+        eb=old_in_start[i+1];
+        out_start[i]=pos;
+        while (a<ea || b<eb)
+          { bool use_out, next_out, next_in;
+            if (b==eb || (a<ea && old_out[a]<old_in[b]))
+              use_out=next_out=true, next_in=false;
+            else if (a==ea || old_in[b]<old_out[a])
+              use_out=next_out=false, next_in=true;
+            else
+              { next_out=next_in=true;
+                use_out=((node_id)i<=old_out[a]);
+                if (edge_values==NULL && (node_id)i<old_out[a] &&
+                    old_in_attr[b]!=NULL &&
+                    old_in_attr[b]!=old_out_attr[a])
+                  dup_attr[dup_count++]=old_in_attr[b];
+              }
+
+            if (edge_values!=NULL)
+              memcpy(edge_values+pos*edge_size, 
+                     old_edge_values+
+                       (use_out? a: old_in_pos[b])*edge_size,
+                     edge_size);
+            else
+              out_attr[pos]= use_out? old_out_attr[a]: old_in_attr[b];
+            out[pos++]= use_out? old_out[a]: old_in[b];
+
+            if (next_out)
+              a++;
+            if (next_in)
+              b++;
+          }
+      }
+    out_start[n]=pos;
+    assert(pos==entries && dup_count==dups);
+    out_end=in_end=out_start+1;
+    edge_count=edge_slots=entries;
+
+    delete[] old_storage;
+  }
+
+/*-------------------------------------------------------------------
+ * Builds (or removes) the adjacency matrix, according to the
+ * policy, which can be:
+ *   ADJ_MATRIX_NONE    the matrix is removed, if present
+ *   ADJ_MATRIX_AUTO    the matrix is built only if it is not larger
+ *                      than ADJ_MATRIX_MAX_BYTES, and not larger than
+ *                      ADJ_MATRIX_MAX_RATIO times the 'out' edges
+ *   ADJ_MATRIX_ALWAYS  the matrix is built unconditionally
+ * Returns true if the graph has an adjacency matrix. 
+ * The memory used can be obtained from AdjacencyMatrixSize.
+ ------------------------------------------------------------------*/
+bool ARGraph_impl::UseAdjacencyMatrix(int policy)
+  { size_t stride=(n+31)/32;
+    size_t bytes=n*stride*sizeof(unsigned);
+
+    if (policy==ADJ_MATRIX_AUTO &&
+        (bytes>ADJ_MATRIX_MAX_BYTES ||
+         bytes>ADJ_MATRIX_MAX_RATIO*edge_count*sizeof(node_id)))
+      policy=ADJ_MATRIX_NONE;
+
+    if (policy==ADJ_MATRIX_NONE)
+      { delete[] adj_matrix;
+        adj_matrix=NULL;
+        adj_stride=0;
+        return false;
+      }
+
+    if (adj_matrix!=NULL)
+      return true;
+
+    adj_matrix=new unsigned[n*stride];
+    ptrcheck(adj_matrix);
+    adj_stride=stride;
+    memset(adj_matrix, 0, bytes);
+
+    int i;
+    offset_type e;
+    for(i=0; i<n; i++)
+      { unsigned *row=adj_matrix+i*stride;
+        for(e=out_start[i]; e<out_end[i]; e++)
+          row[out[e]>>5] |= 1u << (out[e]&31);
+      }
+    return true;
+  }
+
+/*-------------------------------------------------------------------
+ * Returns the heap memory used by the graph (in bytes): the
+ * object itself, the edge vectors, the attributes stored by
+ * value, and the optional int labels, adjacency matrix, hub
+ * tables, original ids and node signatures.
+ * The attributes stored by pointer are not counted, nor are
+ * the destroyer/comparator objects and the overhead of the
+ * memory allocator.
+ ------------------------------------------------------------------*/
+size_t ARGraph_impl::MemoryUsage()
+  { size_t size=sizeof(ARGraph_impl)+IndexMemoryUsage();
+    if (storage!=NULL)
+      size+=StorageSize(n, edge_slots, node_size, edge_size, undirected);
+    size+=dup_count*sizeof(void*);
+    return size;
+  }
+
+/*-------------------------------------------------------------------
+ * Memory used by the optional vectors added to the edge
+ * vectors: int labels, adjacency matrix, hub tables, original
+ * ids and node signatures
+ ------------------------------------------------------------------*/
+size_t ARGraph_impl::IndexMemoryUsage()
+  { size_t size=AdjacencyMatrixSize();
+    if (node_label!=NULL)
+      size+=(n+1)*sizeof(int);
+    if (edge_label!=NULL)
+      size+=((undirected? 1: 2)*edge_slots+1)*sizeof(int);
+    size+=HubTablesSize();
+    if (orig_id!=NULL)
+      size+=2*n*sizeof(node_id);
+    if (signature!=NULL)
+      size+=(n+1)*sizeof(signature_type);
+    return size;
+  }
+
+/*-------------------------------------------------------------------
+ * Memory used by the hash tables of the hub nodes
+ ------------------------------------------------------------------*/
+size_t ARGraph_impl::HubTablesSize()
+  { if (hub_count==0)
+      return 0;
+    return hub_count*sizeof(node_id) +
+           (hub_count+1)*sizeof(offset_type) +
+           hub_start[hub_count]*sizeof(unsigned);
+  }
+
+/*-------------------------------------------------------------------
+ * Estimates the memory that MemoryUsage would report for a
+ * graph built from a loader with the given number of nodes and
+ * edges, and the given sizes of the attributes stored by value
+ * (0 for attributes stored by pointer).
+ * For an undirected graph, edges is the number of distinct
+ * edges (each of them is stored at both ends).
+ * The optional int labels, adjacency matrix and signatures are
+ * not included, nor are the hub tables.
+ ------------------------------------------------------------------*/
+size_t ARGraph_impl::EstimateMemoryUsage(int nodes, size_t edges,
+                                         size_t node_size,
+                                         size_t edge_size,
+                                         bool undirected)
+  { if (undirected)
+      edges*=2;
+    return sizeof(ARGraph_impl) +
+           StorageSize(nodes, edges, node_size, edge_size, undirected);
+  }
+
+/*-------------------------------------------------------------------
+ * Makes the graph keep a copy of the node and/or edge attributes
+ * as ints, to be compared for equality by the matching states
+ * (see CompatibleNodes and the related methods) instead of
+ * using CompatibleNode/CompatibleEdge. 
+ * The attributes must point to ints (a NULL attribute is 
+ * taken as label 0); the labels are kept up to date by
+ * SetNodeAttr and SetEdgeAttr.
+ * The inline comparison is used only if both the graphs being
+ * matched have int labels; a false parameter removes the labels.
+ ------------------------------------------------------------------*/
+void ARGraph_impl::UseIntLabels(bool nodes, bool edges)
+  { int i;
+    offset_type e;
+    delete[] node_label;
+    delete[] edge_label;
+    node_label=edge_label=in_label=NULL;
+
+    if (nodes)
+      { node_label=new int[n+1];
+        ptrcheck(node_label);
+        for(i=0; i<n; i++)
+          node_label[i]=IntLabel(GetNodeAttr(i));
+      }
+
+    if (edges && undirected)
+      { edge_label=in_label=new int[edge_slots+1];
+        ptrcheck(edge_label);
+        for(i=0; i<n; i++)
+          for(e=out_start[i]; e<out_end[i]; e++)
+            edge_label[e]=IntLabel(OutAttr(e));
+      }
+    else if (edges)
+      { edge_label=new int[2*edge_slots+1];
+        ptrcheck(edge_label);
+        in_label=edge_label+edge_slots;
+        for(i=0; i<n; i++)
+          for(e=out_start[i]; e<out_end[i]; e++)
+            edge_label[e]=IntLabel(OutAttr(e));
+        for(i=0; i<n; i++)
+          for(e=in_start[i]; e<in_end[i]; e++)
+            in_label[e]=edge_label[FindOutEdge(in[e], i)];
+      }
+
+    if (signature!=NULL)
+      UseSignatures(true);
+  }
+
+/*-------------------------------------------------------------------
+ * Makes the graph keep a signature for each node, used by the
+ * matching states to discard most of the incompatible pairs of
+ * nodes without looking at their edges (see the notes at the
+ * beginning of argraph.h); a false parameter removes the 
+ * signatures.
+ * If the graph has int node labels (see UseIntLabels), the
+ * signatures include the labels of the neighbors; they are kept
+ * up to date by SetNodeAttr and UseIntLabels. 
+ ------------------------------------------------------------------*/
+void ARGraph_impl::UseSignatures(bool use)
+  { if (!use)
+      { delete[] signature;
+        signature=NULL;
+        return;
+      }
+
+    if (signature==NULL)
+      { signature=new signature_type[n+1];
+        ptrcheck(signature);
+      }
+    int i;
+    for(i=0; i<n; i++)
+      ComputeSignature(i);
+  }
+
+/*-------------------------------------------------------------------
+ * Computes the signature of a node from its edges and from the
+ * labels of its neighbors
+ ------------------------------------------------------------------*/
+void ARGraph_impl::ComputeSignature(node_id i)
+  { offset_type out_deg=out_end[i]-out_start[i];
+    offset_type in_deg=in_end[i]-in_start[i];
+    if (out_deg>SIG_MAX_DEGREE)
+      out_deg=SIG_MAX_DEGREE;
+    if (in_deg>SIG_MAX_DEGREE)
+      in_deg=SIG_MAX_DEGREE;
+
+    signature_type sig=(signature_type)out_deg | 
+                       (signature_type)in_deg<<8;
+    if (node_label!=NULL)
+      { offset_type e;
+        for(e=out_start[i]; e<out_end[i]; e++)
+          sig|=label_bit(node_label[out[e]], 0);
+        for(e=in_start[i]; e<in_end[i]; e++)
+          sig|=label_bit(node_label[in[e]], 1);
+      }
+    signature[i]=sig;
+  }
+
+/*-------------------------------------------------------------------
+ * Returns the bits of the signatures that can be compared when
+ * matching g1 against g2: none if one of the graphs has no
+ * signatures, only the degrees if one of them has no int node
+ * labels, or if labels is false (i.e. the nodes are not compared
+ * by their labels), all the bits otherwise.
+ ------------------------------------------------------------------*/
+ARGraph_impl::signature_type 
+ARGraph_impl::SignatureMask(ARGraph_impl *g1, ARGraph_impl *g2, 
+                            bool labels)
+  { if (!g1->HasSignatures() || !g2->HasSignatures())
+      return 0;
+    if (!labels || !g1->HasIntNodeLabels() || !g2->HasIntNodeLabels())
+      return SIG_DEGREES;
+    return SIG_DEGREES | SIG_LABELS;
+  }
+
+/*-------------------------------------------------------------------
+ * The int label corresponding to an attribute
+ ------------------------------------------------------------------*/
+int ARGraph_impl::IntLabel(void *attr)
+  { return attr==NULL? 0: *(int *)attr;
+  }
+
+/*-------------------------------------------------------------------
+ * Sets the original ids of the nodes, for a graph whose nodes
+ * have been renumbered: ids[i] is the original id of node i.
+ * The vector must be a permutation allocated with new[]; it
+ * becomes owned by the graph. Passing NULL removes the
+ * original ids.
+ ------------------------------------------------------------------*/
+void ARGraph_impl::SetOriginalIds(node_id *ids)
+  { delete[] orig_id;
+    delete[] new_id;
+    orig_id=ids;
+    new_id=NULL;
+    if (ids==NULL)
+      return;
+
+    new_id=new node_id[n];
+    ptrcheck(new_id);
+    int i;
+    for(i=0; i<n; i++)
+      new_id[i]=NULL_NODE;
+    for(i=0; i<n; i++)
+      { if (ids[i]>=(node_id)n || new_id[ids[i]]!=NULL_NODE)
+          error("ARGraph_impl: the original ids are not a permutation");
+        new_id[ids[i]]=i;
+      }
+  }
+
 /*-------------------------------------------------------------------
  * Set the object to invoke to destroy node attributes
  * Note:
@@ -232,10 +975,27 @@ void ARGraph_impl::SetEdgeCompat(edge_compat_fn fn)
   }
 
 /*-------------------------------------------------------------------
- * Change the attribute of a node
+ * Change the attribute of a node.
+ * If the attributes are stored by value, the new attribute is
+ * copied into the graph, and destroyOld is ignored.
  -------------------------------------------------------------------*/
 void ARGraph_impl::SetNodeAttr(node_id i, void *new_attr, bool destroyOld)
-  { assert(i<n);
+  { assert(i<(node_id)n);
+    if (node_label!=NULL)
+      { int old_label=node_label[i];
+        node_label[i]=IntLabel(new_attr);
+        if (signature!=NULL && node_label[i]!=old_label)
+          { offset_type e;
+            for(e=out_start[i]; e<out_end[i]; e++)
+              ComputeSignature(out[e]);
+            for(e=in_start[i]; e<in_end[i]; e++)
+              ComputeSignature(in[e]);
+          }
+      }
+    if (node_values!=NULL)
+      { StoreValue(node_values+i*node_size, new_attr, node_size);
+        return;
+      }
     if (destroyOld)
       DestroyNode(attr[i]);
     attr[i]=new_attr;
@@ -244,78 +1004,174 @@ void ARGraph_impl::SetNodeAttr(node_id i, void *new_attr, bool destroyOld)
 /*-------------------------------------------------------------------
  * Checks the existence of an edge, and returns its attribute
  * using the parameter pattr.
- * Note: uses binary search.
- * Implem. note: Uses the out/out_attr vectors; this fact is 
- *               exploited in the constructor to generate the 
- *               in_attr vector
+ * Note: the adjacency matrix (if present) is checked first;
+ *       then the edge is looked for using FindOutEdge.
  ------------------------------------------------------------------*/
 bool ARGraph_impl::HasEdge(node_id n1, node_id n2, void **pattr)
-  { register int a, b, c;
-    node_id *id=out[n1];
+  { assert(n1<(node_id)n);
+    assert(n2<(node_id)n);
+
+    offset_type pos=EdgePosition(n1, n2);
+    if (pos==NO_EDGE)
+      return false;
+    if (pattr)
+      *pattr=OutAttr(pos);
+    return true;
+  }
+
+/*-------------------------------------------------------------------
+ * Returns the position of the edge (n1, n2) in the 'out' vectors,
+ * or NO_EDGE if the edge does not exist.
+ * The search method depends on the number of edges of n1:
+ * a linear scan for very short lists, a probe of the hash table
+ * for hub nodes (see BuildHubTables), and a binary search 
+ * otherwise.
+ ------------------------------------------------------------------*/
+ARGraph_impl::offset_type ARGraph_impl::FindOutEdge(node_id n1, node_id n2)
+  { offset_type a, b, c;
+    node_id *id=out;
 
-    assert(n1<n);
-    assert(n2<n);
+    a=out_start[n1];
+    b=out_end[n1];
+
+    if (b-a<=LINEAR_SEARCH_MAX)
+      { for(c=a; c<b && id[c]<n2; c++)
+          ;
+        return (c<b && id[c]==n2)? c: NO_EDGE;
+      }
+
+    if (b-a>=HUB_DEGREE && hub_count>0)
+      { // Find the hash table of the node
+        int lo=0, hi=hub_count, k;
+        while (lo<hi)
+          { k=(lo+hi)>>1;
+            if (hub_node[k]<n1)
+              lo=k+1;
+            else
+              hi=k;
+          }
+        assert(lo<hub_count && hub_node[lo]==n1);
+        unsigned *slot=hub_slot+hub_start[lo];
+        offset_type mask=hub_start[lo+1]-hub_start[lo]-1;
+        offset_type h=hub_hash(n2) & mask;
+        while (slot[h]!=0)
+          { c=a+slot[h]-1;
+            if (id[c]==n2)
+              return c;
+            h=(h+1) & mask;
+          }
+        return NO_EDGE;
+      }
 
-    a=0;
-    b=out_count[n1];
     while (a<b)
-      { c=(unsigned)(a+b)>>1;
+      { c=a+((b-a)>>1);
         if (id[c]<n2)
           a=c+1;
         else if (id[c]>n2)
           b=c;
         else
-          { if (pattr)
-		      *pattr=out_attr[n1][c];
-			return true;
-		  }
+          return c;
+      }
+    return NO_EDGE;
+  }
+
+/*-------------------------------------------------------------------
+ * Builds an open-addressing hash table (with linear probing) for
+ * each node having at least HUB_DEGREE 'out' edges. 
+ * Each table has a power of two size, at least twice the number 
+ * of edges of the node, and contains the index (plus one) of 
+ * the edges in the node's list; a 0 marks an empty slot.
+ * The hub nodes are kept in the sorted vector hub_node, and
+ * the table of the k-th hub starts at hub_slot+hub_start[k].
+ ------------------------------------------------------------------*/
+void ARGraph_impl::BuildHubTables()
+  { int i, k;
+    offset_type size=0;
+
+    hub_count=0;
+    for(i=0; i<n; i++)
+      if (out_start[i+1]-out_start[i]>=HUB_DEGREE)
+        { hub_count++;
+          size+=hub_table_size(out_start[i+1]-out_start[i]);
+        }
+    if (hub_count==0)
+      return;
+
+    hub_node=new node_id[hub_count];
+    hub_start=new offset_type[hub_count+1];
+    hub_slot=new unsigned[size];
+    ptrcheck(hub_node);
+    ptrcheck(hub_start);
+    ptrcheck(hub_slot);
+    memset(hub_slot, 0, size*sizeof(hub_slot[0]));
+
+    offset_type pos=0, e;
+    for(i=0, k=0; i<n; i++)
+      { offset_type deg=out_start[i+1]-out_start[i];
+        if (deg<HUB_DEGREE)
+          continue;
+        hub_node[k]=i;
+        hub_start[k]=pos;
+        offset_type tsize=hub_table_size(deg);
+        unsigned *slot=hub_slot+pos;
+        for(e=0; e<deg; e++)
+          { offset_type h=hub_hash(out[out_start[i]+e]) & (tsize-1);
+            while (slot[h]!=0)
+              h=(h+1) & (tsize-1);
+            slot[h]=e+1;
+          }
+        pos+=tsize;
+        k++;
       }
-    return false;
+    hub_start[k]=pos;
   }
 
 /*-------------------------------------------------------------------
  * Change the attribute of an edge. It is an error if the edge
  * does not exist.
+ * If the attributes are stored by value, the new attribute is
+ * copied into the graph, and destroyOld is ignored.
+ * In an undirected graph the 'in' vectors are the 'out' vectors,
+ * so the search of the 'in' edge finds the other copy of the
+ * edge (n2, n1).
  * Note: uses binary search.
  ------------------------------------------------------------------*/
 void  ARGraph_impl::SetEdgeAttr(node_id n1, node_id n2, void *new_attr,
                                 bool destroyOld)
-  { register int a, b, c;
+  { offset_type a, b, c;
     node_id *id;
 
-    assert(n1<n);
-    assert(n2<n);
+    assert(n1<(node_id)n);
+    assert(n2<(node_id)n);
 
     //
     // Replace the attribute in the out_attr array
     //
-    id=out[n1];
-    a=0;
-    b=out_count[n1];
-    while (a<b)
-      { c=(unsigned)(a+b)>>1;
-        if (id[c]<n2)
-          a=c+1;
-        else if (id[c]>n2)
-          b=c;
-        else
-          { if (destroyOld)
-              DestroyEdge(out_attr[n1][c]);
-            out_attr[n1][c]=new_attr;
-	    break;
-          }
-      }
-    if (a>=b)
+    c=FindOutEdge(n1, n2);
+    if (c==NO_EDGE)
       error("ARGraph_impl::SetEdgeAttr: non existent edge");
+    if (edge_label!=NULL)
+      edge_label[c]=IntLabel(new_attr);
+    if (edge_values!=NULL)
+      { // The 'in' edges refer to the same value thru in_pos
+        StoreValue(edge_values+c*edge_size, new_attr, edge_size);
+        if (in_label==NULL && !undirected)
+          return;
+      }
+    else
+      { if (destroyOld)
+          DestroyEdge(out_attr[c]);
+        out_attr[c]=new_attr;
+      }
    
     //
     // Replace the attribute in the in_attr array
     //
-    id = in[n2];
-    a=0;
-    b=in_count[n2];
+    id = in;
+    a=in_start[n2];
+    b=in_end[n2];
     while (a<b)
-      { c=(unsigned)(a+b)>>1;
+      { c=a+((b-a)>>1);
         if (id[c]<n1)
           a=c+1;
         else if (id[c]>n1)
@@ -324,7 +1180,12 @@ void  ARGraph_impl::SetEdgeAttr(node_id n1, node_id n2, void *new_attr,
           { // The old attr here is intentionally
 	    // not destroyed with DestroyEdge, since destruction
 	    // has been performed previously through out_attr
-            in_attr[n2][c]=new_attr;
+            if (in_attr!=NULL)
+              in_attr[c]=new_attr;
+            else if (undirected)
+              StoreValue(edge_values+c*edge_size, new_attr, edge_size);
+            if (in_label!=NULL)
+              in_label[c]=IntLabel(new_attr);
 	    break;
           }
       }
@@ -340,10 +1201,10 @@ void  ARGraph_impl::SetEdgeAttr(node_id n1, node_id n2, void *new_attr,
 void ARGraph_impl::VisitInEdges(node_id node, edge_visitor vis, 
                                 param_type param)
   { 
-    assert(node<n);
-    int i;
-    for(i=0; i<in_count[node]; i++)
-      vis(this, in[node][i], node, in_attr[node][i], param);
+    assert(node<(node_id)n);
+    offset_type i;
+    for(i=in_start[node]; i<in_end[node]; i++)
+      vis(this, in[i], node, InAttr(i), param);
   }
 
 /*-------------------------------------------------------------------
@@ -353,10 +1214,10 @@ void ARGraph_impl::VisitInEdges(node_id node, edge_visitor vis,
 void ARGraph_impl::VisitOutEdges(node_id node, edge_visitor vis, 
                                  param_type param)
   {
-    assert(node<n); 
-    int i;
-    for(i=0; i<out_count[node]; i++)
-      vis(this, node, out[node][i], out_attr[node][i], param);
+    assert(node<(node_id)n); 
+    offset_type i;
+    for(i=out_start[node]; i<out_end[node]; i++)
+      vis(this, node, out[i], OutAttr(i), param);
   }
 
 /*-------------------------------------------------------------------
@@ -0,0 +1,230 @@
+/*--------------------------------------------------------
+ * batch.cc
+ * Implementation of the batch_match function
+ * See: batch.h
+ --------------------------------------------------------*/
+
+#include <limits.h>
+#include <chrono>
+#ifndef VF_NO_THREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#include "argraph.h"
+#include "batch.h"
+#include "error.h"
+
+
+/*---------------------------------------------------------------
+ * Wall clock time, in seconds
+ --------------------------------------------------------------*/
+static double now()
+  { return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+
+/*----------------------------------------------------------------
+ * methods of the class PairLoader
+ ---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Releases a pair after it has been visited: by default the
+ * loader is assumed to have allocated both the graphs with new
+ ---------------------------------------------------------------*/
+void PairLoader::Release(int k, Graph *g1, Graph *g2)
+  { delete g1;
+    delete g2;
+  }
+
+
+#ifndef VF_NO_THREADS
+/*---------------------------------------------------------------
+ * The ring buffer shared by the visitor and the loader threads.
+ * Pair k goes in slot k % depth; it can be claimed by a loader
+ * only when k < next_match+depth, so its slot is free.
+ * All the fields are protected by 'lock'.
+ --------------------------------------------------------------*/
+struct batch_slot
+  { int k;
+    Graph *g1, *g2;
+    bool ready;
+  };
+
+struct batch_queue
+  { PairLoader *loader;
+    int depth;
+    batch_slot *slot;
+    int next_load;      /* next pair to be claimed by a loader */
+    int next_match;     /* next pair to be visited */
+    int end;            /* number of pairs, when known; else INT_MAX */
+    bool stop;
+    double load_time, stall_time;
+    std::mutex lock;
+    std::condition_variable loaded;  /* a pair is ready, or the end */
+    std::condition_variable freed;   /* a slot is free, or stop */
+  };
+
+/*---------------------------------------------------------------
+ * Body of a loader thread
+ --------------------------------------------------------------*/
+static void load_pairs(batch_queue *q)
+  { std::unique_lock<std::mutex> lk(q->lock);
+    for(;;)
+      { if (!q->stop && q->next_load<q->end &&
+            q->next_load>=q->next_match+q->depth)
+          { double t=now();
+            while (!q->stop && q->next_load<q->end &&
+                   q->next_load>=q->next_match+q->depth)
+              q->freed.wait(lk);
+            q->stall_time+=now()-t;
+          }
+        if (q->stop || q->next_load>=q->end)
+          break;
+
+        int k=q->next_load++;
+        lk.unlock();
+        Graph *g1=NULL, *g2=NULL;
+        double t=now();
+        bool ok=q->loader->Load(k, &g1, &g2);
+        t=now()-t;
+        lk.lock();
+
+        q->load_time+=t;
+        if (ok)
+          { // Stored even if the batch has ended meanwhile:
+            // the pair is released by batch_match
+            batch_slot *s=&q->slot[k % q->depth];
+            s->k=k;
+            s->g1=g1;
+            s->g2=g2;
+            s->ready=true;
+          }
+        else if (k<q->end)
+          { q->end=k;
+            q->freed.notify_all();
+          }
+        q->loaded.notify_all();
+      }
+  }
+#endif
+
+
+/*------------------------------------------------------------
+ * int batch_match(loader, vis, usr_data, depth, threads, stats)
+ * Visits in order the graph pairs provided by loader, using
+ * 'threads' background threads to load up to 'depth' pairs
+ * ahead of the one being visited.
+ * Returns the number of visited pairs, and fills *stats if
+ * stats is not NULL.
+ * Stops when there are no more pairs, or the visitor vis
+ * returns true.
+ ----------------------------------------------------------*/
+int batch_match(PairLoader *loader, pair_visitor vis, void *usr_data,
+                int depth, int threads, batch_stats *stats)
+  { double start=now(), t;
+    double match_time=0, wait_time=0;
+    int count=0;
+
+    if (depth<1)
+      depth=1;
+    if (threads<1)
+      threads=1;
+
+#ifndef VF_NO_THREADS
+    batch_queue q;
+    q.loader=loader;
+    q.depth=depth;
+    q.slot=new batch_slot[depth];
+    if (q.slot==NULL)
+      OUT_OF_MEMORY();
+    int i;
+    for(i=0; i<depth; i++)
+      q.slot[i].ready=false;
+    q.next_load=q.next_match=0;
+    q.end=INT_MAX;
+    q.stop=false;
+    q.load_time=q.stall_time=0;
+
+    std::thread *thr=new std::thread[threads];
+    if (thr==NULL)
+      OUT_OF_MEMORY();
+    for(i=0; i<threads; i++)
+      thr[i]=std::thread(load_pairs, &q);
+
+    std::unique_lock<std::mutex> lk(q.lock);
+    for(;;)
+      { batch_slot *s=&q.slot[q.next_match % depth];
+        if (!s->ready && q.next_match<q.end)
+          { t=now();
+            while (!s->ready && q.next_match<q.end)
+              q.loaded.wait(lk);
+            wait_time+=now()-t;
+          }
+        if (q.next_match>=q.end)
+          break;
+
+        int k=q.next_match++;
+        Graph *g1=s->g1, *g2=s->g2;
+        s->ready=false;
+        q.freed.notify_all();
+        lk.unlock();
+
+        t=now();
+        bool stop=vis(k, g1, g2, usr_data);
+        match_time+=now()-t;
+        count++;
+        loader->Release(k, g1, g2);
+
+        lk.lock();
+        if (stop)
+          break;
+      }
+    q.stop=true;
+    q.freed.notify_all();
+    lk.unlock();
+
+    for(i=0; i<threads; i++)
+      thr[i].join();
+    delete[] thr;
+
+    // The pairs loaded beyond the end of the visit
+    for(i=0; i<depth; i++)
+      if (q.slot[i].ready)
+        loader->Release(q.slot[i].k, q.slot[i].g1, q.slot[i].g2);
+    delete[] q.slot;
+    double load_time=q.load_time, stall_time=q.stall_time;
+
+#else
+    double load_time=0, stall_time=0;
+    int k;
+    for(k=0; ; k++)
+      { Graph *g1=NULL, *g2=NULL;
+        t=now();
+        bool ok=loader->Load(k, &g1, &g2);
+        load_time+=now()-t;
+        if (!ok)
+          break;
+
+        t=now();
+        bool stop=vis(k, g1, g2, usr_data);
+        match_time+=now()-t;
+        count++;
+        loader->Release(k, g1, g2);
+        if (stop)
+          break;
+      }
+#endif
+
+    if (stats!=NULL)
+      { stats->pairs=count;
+        stats->total_time=now()-start;
+        stats->load_time=load_time;
+        stats->match_time=match_time;
+        stats->wait_time=wait_time;
+        stats->stall_time=stall_time;
+      }
+    return count;
+  }
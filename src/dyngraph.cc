@@ -0,0 +1,512 @@
+/*--------------------------------------------------------
+ * dyngraph.cc
+ * Implementation of the DynamicGraph class
+ * See: dyngraph.h
+ --------------------------------------------------------*/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "argraph.h"
+#include "dyngraph.h"
+#include "error.h"
+
+
+#define VCOPY(dest, src, type, nelem) memcpy((dest),(src),(nelem)*sizeof(type))
+
+/*---------------------------------------------------------------
+ * Reallocates a vector, keeping its first 'used' elements
+ --------------------------------------------------------------*/
+template <class T, class S>
+static inline void resize(T* &ptr, S used, S new_size)
+  { T* nptr=new T[new_size];
+    if (nptr==NULL)
+      OUT_OF_MEMORY();
+    if (used>0)
+      VCOPY(nptr, ptr, T, used);
+    delete[] ptr;
+    ptr=nptr;
+  }
+
+/*---------------------------------------------------------------
+ * The node at the other end of a queued edge operation, as seen
+ * from the 'out' or the 'in' list being merged
+ --------------------------------------------------------------*/
+#define OTHER_END(op, in_side)  ((in_side)? (op).from: (op).to)
+
+
+/*----------------------------------------------------------------
+ * methods of the class DynamicGraph
+ ---------------------------------------------------------------*/
+
+/*---------------------------------------------------------------
+ * Constructor: builds an empty graph
+ --------------------------------------------------------------*/
+DynamicGraph::DynamicGraph()
+  { Init();
+  }
+
+/*---------------------------------------------------------------
+ * Constructor: builds the graph provided by the loader.
+ * The lists are filled directly (the 'in' lists by a counting
+ * sort, as in ARGraph_impl), each in a region of its own size.
+ --------------------------------------------------------------*/
+DynamicGraph::DynamicGraph(ARGLoader *loader)
+  { Init();
+
+    int nodes=loader->NodeCount();
+    int i, k;
+    if (nodes>0)
+      GrowNodes(nodes);
+    for(i=0; i<nodes; i++)
+      AddNode(loader->GetNodeAttr(i));
+    n=nodes;
+    new_nodes=0;
+
+    offset_type edges=0, pos, e;
+    for(i=0; i<n; i++)
+      edges+=loader->OutEdgeCount(i);
+    GrowSlots(edges);
+
+    for(i=0, pos=0; i<n; i++)
+      { k=loader->OutEdgeCount(i);
+        out_start[i]=pos;
+        if (pos+k>edges)
+          error("DynamicGraph: inconsistent edge count from the loader");
+        loader->GetOutEdges(i, out+pos, out_attr+pos);
+        pos+=k;
+        out_end[i]=pos;
+        out_cap[i]=k;
+      }
+    if (pos!=edges)
+      error("DynamicGraph: inconsistent edge count from the loader");
+
+    for(e=0; e<edges; e++)
+      in_cap[out[e]]++;
+    for(i=0, pos=0; i<n; i++)
+      { in_start[i]=in_end[i]=pos;
+        pos+=in_cap[i];
+      }
+    for(i=0; i<n; i++)
+      for(e=out_start[i]; e<out_end[i]; e++)
+        { offset_type p=in_end[out[e]]++;
+          in[p]=i;
+          in_attr[p]=out_attr[e];
+        }
+
+    out_used=in_used=edge_count=edges;
+  }
+
+/*---------------------------------------------------------------
+ * Destructor. The attributes are destroyed here, while the
+ * vectors are still there; then the vectors are freed, leaving
+ * to ~ARGraph_impl an empty graph.
+ --------------------------------------------------------------*/
+DynamicGraph::~DynamicGraph()
+  { int i;
+    offset_type e;
+    if (edge_destroyer!=NULL)
+      for(i=0; i<n; i++)
+        for(e=out_start[i]; e<out_end[i]; e++)
+          DestroyEdge(out_attr[e]);
+    if (node_destroyer!=NULL)
+      for(i=0; i<n; i++)
+        DestroyNode(attr[i]);
+    SetNodeDestroyer(NULL);
+    SetEdgeDestroyer(NULL);
+
+    delete[] attr;
+    delete[] out_start;
+    delete[] out_end;
+    delete[] out_cap;
+    delete[] in_start;
+    delete[] in_end;
+    delete[] in_cap;
+    delete[] out;
+    delete[] out_attr;
+    delete[] in;
+    delete[] in_attr;
+    delete[] ops;
+    delete[] tmp_id;
+    delete[] tmp_attr;
+
+    attr=out_attr=in_attr=NULL;
+    out_start=out_end=in_start=in_end=NULL;
+    out=in=NULL;
+    n=0;
+  }
+
+/*---------------------------------------------------------------
+ * Initializes the members of an empty graph
+ --------------------------------------------------------------*/
+void DynamicGraph::Init()
+  { node_cap=0;
+    out_cap=in_cap=NULL;
+    out_used=in_used=0;
+    out_free=in_free=0;
+    new_nodes=0;
+    ops=NULL;
+    op_count=op_cap=0;
+    tmp_id=NULL;
+    tmp_attr=NULL;
+    tmp_cap=0;
+  }
+
+/*---------------------------------------------------------------
+ * Adds a node, returning its id. The node will be part of the
+ * graph after the next Commit.
+ --------------------------------------------------------------*/
+node_id DynamicGraph::AddNode(void *nattr)
+  { if (orig_id!=NULL)
+      error("DynamicGraph::AddNode: the graph has been relabeled");
+    int id=n+new_nodes;
+    if ((node_id)id>=NULL_NODE)
+      error("DynamicGraph::AddNode: too many nodes");
+    if (id>=node_cap)
+      GrowNodes(node_cap<8? 8: 2*node_cap);
+
+    attr[id]=nattr;
+    out_start[id]=out_end[id]=out_cap[id]=0;
+    in_start[id]=in_end[id]=in_cap[id]=0;
+    new_nodes++;
+    return id;
+  }
+
+/*---------------------------------------------------------------
+ * Queues the insertion of the edge (n1, n2)
+ --------------------------------------------------------------*/
+void DynamicGraph::AddEdge(node_id n1, node_id n2, void *eattr)
+  { if (n1>=(node_id)(n+new_nodes) || n2>=(node_id)(n+new_nodes))
+      error("Bad param in DynamicGraph::AddEdge");
+    if (op_count==op_cap)
+      resize(ops, op_count, op_cap=(op_cap<16? 16: 2*op_cap));
+    edge_op *op=&ops[op_count];
+    op->from=n1;
+    op->to=n2;
+    op->seq=op_count++;
+    op->remove=false;
+    op->attr=eattr;
+  }
+
+/*---------------------------------------------------------------
+ * Queues the removal of the edge (n1, n2)
+ --------------------------------------------------------------*/
+void DynamicGraph::RemoveEdge(node_id n1, node_id n2)
+  { if (n1>=(node_id)(n+new_nodes) || n2>=(node_id)(n+new_nodes))
+      error("Bad param in DynamicGraph::RemoveEdge");
+    if (op_count==op_cap)
+      resize(ops, op_count, op_cap=(op_cap<16? 16: 2*op_cap));
+    edge_op *op=&ops[op_count];
+    op->from=n1;
+    op->to=n2;
+    op->seq=op_count++;
+    op->remove=true;
+    op->attr=NULL;
+  }
+
+/*---------------------------------------------------------------
+ * Applies the queued operations.
+ * The operations are sorted by source node, and the ones
+ * regarding each node are merged into its 'out' list; then
+ * they are sorted by destination, and merged into the 'in'
+ * lists. The adjacency matrix, if present, is updated bit by
+ * bit, or rebuilt if nodes have been added; the signatures, if
+ * present, are recomputed for the nodes whose lists have 
+ * changed.
+ --------------------------------------------------------------*/
+void DynamicGraph::Commit()
+  { if (op_count==0 && new_nodes==0)
+      return;
+
+    int i, j;
+    int old_n=n;
+    n+=new_nodes;
+    new_nodes=0;
+
+    if (node_label!=NULL && n>old_n)
+      { int *label=new int[n+1];
+        if (label==NULL)
+          OUT_OF_MEMORY();
+        VCOPY(label, node_label, int, old_n);
+        for(i=old_n; i<n; i++)
+          label[i]=IntLabel(attr[i]);
+        delete[] node_label;
+        node_label=label;
+      }
+    if (signature!=NULL && n>old_n)
+      resize(signature, old_n, n+1);
+
+    bool rebuild_matrix=(adj_matrix!=NULL && n>old_n);
+    if (rebuild_matrix)
+      UseAdjacencyMatrix(ADJ_MATRIX_NONE);
+
+    qsort(ops, op_count, sizeof(ops[0]), OutOrderComp);
+    for(i=0; i<op_count; i=j)
+      { for(j=i+1; j<op_count && ops[j].from==ops[i].from; j++)
+          ;
+        MergeList(ops[i].from, ops+i, j-i, false);
+        if (signature!=NULL)
+          ComputeSignature(ops[i].from);
+      }
+
+    qsort(ops, op_count, sizeof(ops[0]), InOrderComp);
+    for(i=0; i<op_count; i=j)
+      { for(j=i+1; j<op_count && ops[j].to==ops[i].to; j++)
+          ;
+        MergeList(ops[i].to, ops+i, j-i, true);
+        if (signature!=NULL)
+          ComputeSignature(ops[i].to);
+      }
+    op_count=0;
+    if (signature!=NULL)
+      for(i=old_n; i<n; i++)
+        ComputeSignature(i);
+
+    if (out_free>edge_count+COMPACT_SLACK || 
+        in_free>edge_count+COMPACT_SLACK)
+      Compact();
+
+    if (rebuild_matrix)
+      UseAdjacencyMatrix(ADJ_MATRIX_ALWAYS);
+  }
+
+/*---------------------------------------------------------------
+ * Merges the 'count' operations starting at op, all regarding
+ * 'node' and sorted by the other node, into the 'out' (or
+ * 'in') list of the node. The attributes of the removed edges
+ * are destroyed while processing the 'out' lists.
+ * If the new list does not fit into its region, it is moved
+ * to a new region at the end of the vectors.
+ --------------------------------------------------------------*/
+void DynamicGraph::MergeList(node_id node, edge_op *op, int count,
+                             bool in_side)
+  { offset_type *start= in_side? in_start: out_start;
+    offset_type *end= in_side? in_end: out_end;
+    offset_type *cap= in_side? in_cap: out_cap;
+    node_id *ids= in_side? in: out;
+    void* *attrs= in_side? in_attr: out_attr;
+
+    offset_type a=start[node], b=end[node];
+    offset_type need=b-a+count;
+    if (need>tmp_cap)
+      { tmp_cap= (need>2*tmp_cap)? need: 2*tmp_cap;
+        resize(tmp_id, (offset_type)0, tmp_cap);
+        resize(tmp_attr, (offset_type)0, tmp_cap);
+      }
+
+    offset_type p=a, m=0;
+    int k=0;
+    while (p<b || k<count)
+      { node_id other= (k<count)? OTHER_END(op[k], in_side): NULL_NODE;
+        if (p<b && (k>=count || ids[p]<other))
+          { tmp_id[m]=ids[p];
+            tmp_attr[m++]=attrs[p++];
+            continue;
+          }
+
+        bool present=(p<b && ids[p]==other);
+        void *eattr=present? attrs[p++]: NULL;
+        for(; k<count && OTHER_END(op[k], in_side)==other; k++)
+          { if (op[k].remove)
+              { if (!present)
+                  error("DynamicGraph::Commit: "
+                        "removing the non existent edge (%d, %d)",
+                        (int)op[k].from, (int)op[k].to);
+                if (!in_side)
+                  DestroyEdge(eattr);
+                present=false;
+              }
+            else
+              { if (present)
+                  error("DynamicGraph::Commit: "
+                        "adding the existing edge (%d, %d)",
+                        (int)op[k].from, (int)op[k].to);
+                present=true;
+                eattr=op[k].attr;
+              }
+          }
+        if (present)
+          { tmp_id[m]=other;
+            tmp_attr[m++]=eattr;
+          }
+        if (!in_side && adj_matrix!=NULL)
+          { unsigned *word=adj_matrix+node*adj_stride+(other>>5);
+            if (present)
+              *word |= 1u << (other&31);
+            else
+              *word &= ~(1u << (other&31));
+          }
+      }
+
+    if (!in_side)
+      edge_count=edge_count-(b-a)+m;
+
+    if (m>cap[node])
+      { offset_type &used= in_side? in_used: out_used;
+        offset_type &freed= in_side? in_free: out_free;
+        offset_type ncap= (2*m<MIN_LIST_CAP)? MIN_LIST_CAP: 2*m;
+        if (used+ncap>edge_slots)
+          { GrowSlots((used+ncap>2*edge_slots)? used+ncap: 2*edge_slots);
+            ids= in_side? in: out;
+            attrs= in_side? in_attr: out_attr;
+          }
+        freed+=cap[node];
+        start[node]=used;
+        cap[node]=ncap;
+        used+=ncap;
+      }
+
+    offset_type s=start[node];
+    if (m>0)
+      { VCOPY(ids+s, tmp_id, node_id, m);
+        VCOPY(attrs+s, tmp_attr, void*, m);
+      }
+    end[node]=s+m;
+
+    if (edge_label!=NULL)
+      { int *label= in_side? in_label: edge_label;
+        for(p=0; p<m; p++)
+          label[s+p]=IntLabel(tmp_attr[p]);
+      }
+  }
+
+/*---------------------------------------------------------------
+ * Heap memory used by the graph, including the free space
+ * in the vectors and the queued operations
+ * (see ARGraph_impl::MemoryUsage)
+ --------------------------------------------------------------*/
+size_t DynamicGraph::MemoryUsage()
+  { return sizeof(DynamicGraph) + IndexMemoryUsage() +
+           node_cap*(sizeof(void*)+6*sizeof(offset_type)) +
+           edge_slots*2*(sizeof(node_id)+sizeof(void*)) +
+           op_cap*sizeof(edge_op) +
+           tmp_cap*(sizeof(node_id)+sizeof(void*));
+  }
+
+/*---------------------------------------------------------------
+ * Enlarges the node vectors
+ --------------------------------------------------------------*/
+void DynamicGraph::GrowNodes(int new_cap)
+  { int used=n+new_nodes;
+    resize(attr, used, new_cap);
+    resize(out_start, used, new_cap);
+    resize(out_end, used, new_cap);
+    resize(out_cap, used, new_cap);
+    resize(in_start, used, new_cap);
+    resize(in_end, used, new_cap);
+    resize(in_cap, used, new_cap);
+    node_cap=new_cap;
+  }
+
+/*---------------------------------------------------------------
+ * Enlarges the edge vectors (and the int labels of the edges,
+ * if present)
+ --------------------------------------------------------------*/
+void DynamicGraph::GrowSlots(offset_type new_cap)
+  { resize(out, out_used, new_cap);
+    resize(out_attr, out_used, new_cap);
+    resize(in, in_used, new_cap);
+    resize(in_attr, in_used, new_cap);
+
+    if (edge_label!=NULL)
+      { int *label=new int[2*new_cap+1];
+        if (label==NULL)
+          OUT_OF_MEMORY();
+        VCOPY(label, edge_label, int, out_used);
+        VCOPY(label+new_cap, in_label, int, in_used);
+        delete[] edge_label;
+        edge_label=label;
+        in_label=label+new_cap;
+      }
+    edge_slots=new_cap;
+  }
+
+/*---------------------------------------------------------------
+ * Copies the lists into new vectors, in order of node, removing
+ * the space left behind by the lists that have been moved.
+ * Each list keeps the size of its region.
+ --------------------------------------------------------------*/
+void DynamicGraph::Compact()
+  { int i;
+    offset_type out_size=0, in_size=0;
+    for(i=0; i<n; i++)
+      { out_size+=out_cap[i];
+        in_size+=in_cap[i];
+      }
+    offset_type new_cap= (out_size>in_size)? out_size: in_size;
+    new_cap+=new_cap/2+COMPACT_SLACK;
+
+    node_id *nout=new node_id[new_cap];
+    node_id *nin=new node_id[new_cap];
+    void* *nout_attr=new void*[new_cap];
+    void* *nin_attr=new void*[new_cap];
+    int *label= (edge_label!=NULL)? new int[2*new_cap+1]: NULL;
+    if (nout==NULL || nin==NULL || nout_attr==NULL || nin_attr==NULL ||
+        (edge_label!=NULL && label==NULL))
+      OUT_OF_MEMORY();
+
+    offset_type po=0, pi=0, len;
+    for(i=0; i<n; i++)
+      { len=out_end[i]-out_start[i];
+        VCOPY(nout+po, out+out_start[i], node_id, len);
+        VCOPY(nout_attr+po, out_attr+out_start[i], void*, len);
+        if (label!=NULL)
+          VCOPY(label+po, edge_label+out_start[i], int, len);
+        out_start[i]=po;
+        out_end[i]=po+len;
+        po+=out_cap[i];
+
+        len=in_end[i]-in_start[i];
+        VCOPY(nin+pi, in+in_start[i], node_id, len);
+        VCOPY(nin_attr+pi, in_attr+in_start[i], void*, len);
+        if (label!=NULL)
+          VCOPY(label+new_cap+pi, in_label+in_start[i], int, len);
+        in_start[i]=pi;
+        in_end[i]=pi+len;
+        pi+=in_cap[i];
+      }
+
+    delete[] out;
+    delete[] out_attr;
+    delete[] in;
+    delete[] in_attr;
+    out=nout;
+    out_attr=nout_attr;
+    in=nin;
+    in_attr=nin_attr;
+    if (label!=NULL)
+      { delete[] edge_label;
+        edge_label=label;
+        in_label=label+new_cap;
+      }
+
+    edge_slots=new_cap;
+    out_used=po;
+    in_used=pi;
+    out_free=in_free=0;
+  }
+
+/*---------------------------------------------------------------
+ * Orderings of the queued operations, for the 'out' lists
+ * (by source, destination, order of issue) and for the 'in'
+ * lists (by destination, source, order of issue)
+ --------------------------------------------------------------*/
+int DynamicGraph::OutOrderComp(const void *a, const void *b)
+  { const edge_op *x=(const edge_op *)a;
+    const edge_op *y=(const edge_op *)b;
+    if (x->from!=y->from)
+      return x->from<y->from? -1: +1;
+    if (x->to!=y->to)
+      return x->to<y->to? -1: +1;
+    return x->seq - y->seq;
+  }
+
+int DynamicGraph::InOrderComp(const void *a, const void *b)
+  { const edge_op *x=(const edge_op *)a;
+    const edge_op *y=(const edge_op *)b;
+    if (x->to!=y->to)
+      return x->to<y->to? -1: +1;
+    if (x->from!=y->from)
+      return x->from<y->from? -1: +1;
+    return x->seq - y->seq;
+  }
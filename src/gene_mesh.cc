@@ -35,7 +35,7 @@ void GenerateMesh(int nodes, int extra_edges, Graph **g1, Graph **g2,
   { 
     int i, j, n1, n2;
     byte **mat;
-    short *s;
+    node_id *s;
     int sqnodes=(int)(sqrt((double)nodes)+0.5);
     nodes=sqnodes*sqnodes;
     int edges=extra_edges+ 2*sqnodes*(sqnodes-1);
@@ -47,7 +47,7 @@ void GenerateMesh(int nodes, int extra_edges, Graph **g1, Graph **g2,
     mat=new byte*[nodes];
     for(i=0; i<nodes;i++)
       mat[i]=new byte[nodes];
-    s=new short[nodes];
+    s=new node_id[nodes];
 
     if (sub_nodes<=0)
       sub_nodes=nodes;
@@ -0,0 +1,483 @@
+/*--------------------------------------------------------
+ * graphdb.cc
+ * Implementation of the graph database classes
+ * See: graphdb.h
+ --------------------------------------------------------*/
+
+#include <string.h>
+
+#include "argraph.h"
+#include "graphdb.h"
+#include "error.h"
+
+
+/*---------------------------------------------------------------
+ * Header of a graph database. The records start at
+ * DATA_OFFSET; the index (count entries, followed by
+ * count*label_bins label counts) starts at index_offset.
+ * The positions are relative to the start of the header.
+ --------------------------------------------------------------*/
+struct graphdb_header
+  { char magic[8];
+    unsigned version;
+    unsigned byte_order;
+    unsigned flags;
+    unsigned label_bins;
+    unsigned long long node_size;
+    unsigned long long edge_size;
+    unsigned long long count;
+    unsigned long long index_offset;
+  };
+
+/*---------------------------------------------------------------
+ * An entry of the index
+ --------------------------------------------------------------*/
+struct graphdb_entry
+  { unsigned long long offset;  /* position of the record */
+    unsigned nodes;
+    unsigned edges;             /* distinct edges */
+    unsigned flags;
+    unsigned reserved;
+  };
+
+/*---------------------------------------------------------------
+ * Start of a record; it is followed by the vectors start
+ * (nodes+1 elements) and dest (edges elements), and by the
+ * node and edge attributes, each starting at a multiple of
+ * 8 bytes
+ --------------------------------------------------------------*/
+struct graphdb_record
+  { unsigned nodes;
+    unsigned edges;
+    unsigned flags;
+    unsigned reserved;
+  };
+
+static const char DB_MAGIC[8]={ 'V','F','L','I','B','G','D','B' };
+enum { DB_VERSION=1, DB_BYTE_ORDER=0x01020304, DB_UNDIRECTED=1,
+       DATA_OFFSET=64 };
+
+inline size_t align8(size_t bytes)
+  { return (bytes+7) & ~(size_t)7;
+  }
+
+/*---------------------------------------------------------------
+ * Positions in a record of the node and edge attributes, and
+ * size of the record
+ --------------------------------------------------------------*/
+static size_t record_layout(size_t nodes, size_t edges,
+                            size_t node_size, size_t edge_size,
+                            size_t *node_pos, size_t *edge_pos)
+  { *node_pos=align8(sizeof(graphdb_record) +
+                     (nodes+1+edges)*sizeof(unsigned));
+    *edge_pos=*node_pos+align8(nodes*node_size);
+    return *edge_pos+align8(edges*edge_size);
+  }
+
+/*---------------------------------------------------------------
+ * Makes sure that a buffer has at least the given size; its
+ * contents are not kept
+ --------------------------------------------------------------*/
+static void reserve(char* &buffer, size_t &buffer_size, size_t size)
+  { if (size<=buffer_size)
+      return;
+    if (size<2*buffer_size)
+      size=2*buffer_size;
+    delete[] buffer;
+    buffer=new char[size];
+    if (buffer==NULL)
+      OUT_OF_MEMORY();
+    buffer_size=size;
+  }
+
+/*---------------------------------------------------------------
+ * Reads and checks the header of a database
+ --------------------------------------------------------------*/
+static void read_header(std::istream &in, graphdb_header *h)
+  { in.read((char *)h, sizeof(*h));
+    if (!in || memcmp(h->magic, DB_MAGIC, sizeof(DB_MAGIC))!=0 ||
+        h->version!=DB_VERSION)
+      error("GraphDB: not a graph database");
+    if (h->byte_order!=DB_BYTE_ORDER)
+      error("GraphDB: the database was written with a different"
+            " byte order");
+    in.ignore(DATA_OFFSET-sizeof(*h));
+  }
+
+
+/*----------------------------------------------------------------
+ * methods of the class GraphDBLoader
+ ---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Constructor. The loader has no graph until it is filled by
+ * GraphDB::Read or GraphDBStream::Next
+ ---------------------------------------------------------------*/
+GraphDBLoader::GraphDBLoader()
+  { buffer=NULL;
+    buffer_size=0;
+    n=0;
+    undirected=false;
+    start=NULL;
+    dest=NULL;
+    node_values=edge_values=NULL;
+    node_size=edge_size=0;
+  }
+
+GraphDBLoader::~GraphDBLoader()
+  { delete[] buffer;
+  }
+
+/*----------------------------------------------------------------
+ * Reads a record from the current position of the stream,
+ * and checks that it describes a valid graph
+ ---------------------------------------------------------------*/
+void GraphDBLoader::Read(std::istream &in, size_t node_size,
+                         size_t edge_size)
+  { graphdb_record r;
+    in.read((char *)&r, sizeof(r));
+    if (!in)
+      error("GraphDB: read error");
+    if (r.nodes>=NULL_NODE)
+      error("GraphDB: a graph has too many nodes for node_id");
+
+    size_t node_pos, edge_pos, size;
+    size=record_layout(r.nodes, r.edges, node_size, edge_size,
+                       &node_pos, &edge_pos);
+    reserve(buffer, buffer_size, size);
+    memcpy(buffer, &r, sizeof(r));
+    in.read(buffer+sizeof(r), size-sizeof(r));
+    if (!in)
+      error("GraphDB: read error");
+
+    this->node_size=node_size;
+    this->edge_size=edge_size;
+    n=r.nodes;
+    undirected=(r.flags & DB_UNDIRECTED)!=0;
+    start=(unsigned *)(buffer+sizeof(r));
+    dest=start+n+1;
+    node_values=(node_size>0)? buffer+node_pos: NULL;
+    edge_values=(edge_size>0)? buffer+edge_pos: NULL;
+
+    int i;
+    unsigned e;
+    if (start[0]!=0 || start[n]!=r.edges)
+      error("GraphDB: corrupted record");
+    for(i=0; i<n; i++)
+      if (start[i+1]<start[i])
+        error("GraphDB: corrupted record");
+    for(e=0; e<r.edges; e++)
+      if (dest[e]>=(unsigned)n)
+        error("GraphDB: corrupted record");
+  }
+
+/*----------------------------------------------------------------
+ * Copies all the edges of a node; the attributes are
+ * pointers into the record
+ ---------------------------------------------------------------*/
+void GraphDBLoader::GetOutEdges(node_id node, node_id *dest,
+                                void **attrs)
+  { assert(node<(node_id)n);
+    unsigned e=start[node], end=start[node+1];
+    const unsigned *d=this->dest+e;
+    unsigned i, k=end-e;
+    for(i=0; i<k; i++)
+      dest[i]=d[i];
+    if (attrs!=NULL)
+      for(i=0; i<k; i++, e++)
+        attrs[i]=(edge_values==NULL)? NULL: edge_values+e*edge_size;
+  }
+
+/*----------------------------------------------------------------
+ * Builds a graph from the loader, with the attributes stored
+ * by value if they were saved
+ ---------------------------------------------------------------*/
+Graph *GraphDBLoader::NewGraph()
+  { Graph *g=new Graph(this, node_values? node_size: 0,
+                       edge_values? edge_size: 0, undirected);
+    if (g==NULL)
+      OUT_OF_MEMORY();
+    return g;
+  }
+
+
+/*----------------------------------------------------------------
+ * methods of the class GraphDBWriter
+ ---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Constructor. If label_bins is not 0, the graphs must have
+ * int node labels, and a histogram of them is kept in the
+ * index.
+ ---------------------------------------------------------------*/
+GraphDBWriter::GraphDBWriter(std::ostream &out, size_t node_size,
+                             size_t edge_size, int label_bins)
+  : out(out)
+  { this->node_size=node_size;
+    this->edge_size=edge_size;
+    this->label_bins=label_bins;
+    count=capacity=0;
+    index=NULL;
+    hist=NULL;
+    buffer=NULL;
+    buffer_size=0;
+    closed=false;
+
+    // The header is written by Close
+    static const char zeros[DATA_OFFSET]={ 0 };
+    base=out.tellp();
+    out.write(zeros, DATA_OFFSET);
+    pos=DATA_OFFSET;
+  }
+
+GraphDBWriter::~GraphDBWriter()
+  { if (!closed)
+      Close();
+    delete[] index;
+    delete[] hist;
+    delete[] buffer;
+  }
+
+/*----------------------------------------------------------------
+ * Appends a graph to the database
+ ---------------------------------------------------------------*/
+void GraphDBWriter::Add(Graph &g)
+  { if (closed)
+      error("GraphDBWriter::Add: the writer has been closed");
+    if (label_bins>0 && !g.HasIntNodeLabels())
+      error("GraphDBWriter::Add: the graph has no int node labels");
+
+    if (count==capacity)
+      { size_t new_capacity=(capacity==0)? 64: 2*capacity;
+        graphdb_entry *new_index=new graphdb_entry[new_capacity];
+        unsigned *new_hist=new unsigned[new_capacity*label_bins];
+        if (new_index==NULL || new_hist==NULL)
+          OUT_OF_MEMORY();
+        if (count>0)
+          { memcpy(new_index, index, count*sizeof(graphdb_entry));
+            memcpy(new_hist, hist, count*label_bins*sizeof(unsigned));
+          }
+        delete[] index;
+        delete[] hist;
+        index=new_index;
+        hist=new_hist;
+        capacity=new_capacity;
+      }
+
+    int n=g.NodeCount();
+    bool undirected=g.IsUndirected();
+    int i, j, k;
+    size_t edges=0;
+    for(i=0; i<n; i++)
+      { k=g.OutEdgeCount(i);
+        if (!undirected)
+          edges+=k;
+        else
+          for(j=0; j<k; j++)
+            if (g.GetOutEdge(i, j)>=(node_id)i)  // Each undirected edge once
+              edges++;
+      }
+    if (edges>0xFFFFFFFFu)
+      error("GraphDBWriter::Add: too many edges");
+
+    size_t node_pos, edge_pos, size;
+    size=record_layout(n, edges, node_size, edge_size,
+                       &node_pos, &edge_pos);
+    reserve(buffer, buffer_size, size);
+    memset(buffer, 0, size);
+
+    graphdb_record *r=(graphdb_record *)buffer;
+    r->nodes=n;
+    r->edges=edges;
+    r->flags=undirected? DB_UNDIRECTED: 0;
+    unsigned *start=(unsigned *)(buffer+sizeof(graphdb_record));
+    unsigned *dest=start+n+1;
+    unsigned e=0;
+    for(i=0; i<n; i++)
+      { start[i]=e;
+        if (node_size>0 && g.GetNodeAttr(i)!=NULL)
+          memcpy(buffer+node_pos+i*node_size, g.GetNodeAttr(i),
+                 node_size);
+        k=g.OutEdgeCount(i);
+        for(j=0; j<k; j++)
+          { void *attr;
+            node_id other=g.GetOutEdge(i, j, &attr);
+            if (undirected && other<(node_id)i)
+              continue;
+            dest[e]=other;
+            if (edge_size>0 && attr!=NULL)
+              memcpy(buffer+edge_pos+e*edge_size, attr, edge_size);
+            e++;
+          }
+      }
+    start[n]=e;
+
+    graphdb_entry *entry=index+count;
+    entry->offset=pos;
+    entry->nodes=n;
+    entry->edges=edges;
+    entry->flags=r->flags;
+    entry->reserved=0;
+    if (label_bins>0)
+      { unsigned *h=hist+count*label_bins;
+        memset(h, 0, label_bins*sizeof(unsigned));
+        for(i=0; i<n; i++)
+          { int bin=g.NodeLabel(i)%label_bins;
+            h[bin<0? bin+label_bins: bin]++;
+          }
+      }
+
+    out.write(buffer, size);
+    if (!out)
+      error("GraphDBWriter::Add: write error");
+    pos+=size;
+    count++;
+  }
+
+/*----------------------------------------------------------------
+ * Writes the index and completes the header. No graph can
+ * be added after this
+ ---------------------------------------------------------------*/
+void GraphDBWriter::Close()
+  { if (closed)
+      return;
+    closed=true;
+
+    graphdb_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, DB_MAGIC, sizeof(DB_MAGIC));
+    h.version=DB_VERSION;
+    h.byte_order=DB_BYTE_ORDER;
+    h.label_bins=label_bins;
+    h.node_size=node_size;
+    h.edge_size=edge_size;
+    h.count=count;
+    h.index_offset=pos;
+
+    out.write((char *)index, count*sizeof(graphdb_entry));
+    out.write((char *)hist, count*label_bins*sizeof(unsigned));
+    std::ostream::pos_type end=out.tellp();
+    out.seekp(base);
+    out.write((char *)&h, sizeof(h));
+    out.seekp(end);
+    out.flush();
+    if (!out)
+      error("GraphDBWriter::Close: write error");
+  }
+
+
+/*----------------------------------------------------------------
+ * methods of the class GraphDB
+ ---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Constructor. Reads the header and the index of the database
+ * starting at the current position of the stream
+ ---------------------------------------------------------------*/
+GraphDB::GraphDB(std::istream &in)
+  : in(in)
+  { graphdb_header h;
+    base=in.tellg();
+    read_header(in, &h);
+    count=h.count;
+    node_size=h.node_size;
+    edge_size=h.edge_size;
+    label_bins=h.label_bins;
+
+    index=new graphdb_entry[count];
+    hist=new unsigned[count*label_bins];
+    if (index==NULL || hist==NULL)
+      OUT_OF_MEMORY();
+    in.seekg(base+(std::istream::off_type)h.index_offset);
+    in.read((char *)index, count*sizeof(graphdb_entry));
+    in.read((char *)hist, count*label_bins*sizeof(unsigned));
+    if (!in)
+      error("GraphDB: cannot read the index");
+  }
+
+GraphDB::~GraphDB()
+  { delete[] index;
+    delete[] hist;
+  }
+
+int GraphDB::NodeCount(int k)
+  { assert(k>=0 && (size_t)k<count);
+    return index[k].nodes;
+  }
+
+/*----------------------------------------------------------------
+ * Number of edges of a graph; each undirected edge is counted
+ * once
+ ---------------------------------------------------------------*/
+int GraphDB::EdgeCount(int k)
+  { assert(k>=0 && (size_t)k<count);
+    return index[k].edges;
+  }
+
+bool GraphDB::IsUndirected(int k)
+  { assert(k>=0 && (size_t)k<count);
+    return (index[k].flags & DB_UNDIRECTED)!=0;
+  }
+
+/*----------------------------------------------------------------
+ * Number of nodes of graph k whose int label, modulo
+ * LabelBins(), is bin
+ ---------------------------------------------------------------*/
+unsigned GraphDB::LabelCount(int k, int bin)
+  { assert(k>=0 && (size_t)k<count);
+    assert(bin>=0 && bin<label_bins);
+    return hist[k*label_bins+bin];
+  }
+
+/*----------------------------------------------------------------
+ * Fills the loader with graph k
+ ---------------------------------------------------------------*/
+void GraphDB::Read(int k, GraphDBLoader &loader)
+  { if (k<0 || (size_t)k>=count)
+      error("Bad param in GraphDB::Read: %d", k);
+    in.clear();
+    in.seekg(base+(std::istream::off_type)index[k].offset);
+    loader.Read(in, node_size, edge_size);
+    if ((unsigned)loader.n!=index[k].nodes)
+      error("GraphDB: corrupted record");
+  }
+
+/*----------------------------------------------------------------
+ * Builds graph k (see GraphDBLoader::NewGraph)
+ ---------------------------------------------------------------*/
+Graph *GraphDB::NewGraph(int k)
+  { GraphDBLoader loader;
+    Read(k, loader);
+    return loader.NewGraph();
+  }
+
+
+/*----------------------------------------------------------------
+ * methods of the class GraphDBStream
+ ---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Constructor. Reads the header of the database starting at
+ * the current position of the stream
+ ---------------------------------------------------------------*/
+GraphDBStream::GraphDBStream(std::istream &in)
+  : in(in)
+  { graphdb_header h;
+    read_header(in, &h);
+    count=h.count;
+    next=0;
+    node_size=h.node_size;
+    edge_size=h.edge_size;
+  }
+
+/*----------------------------------------------------------------
+ * Fills the loader with the next graph; returns false if
+ * all the graphs have been read
+ ---------------------------------------------------------------*/
+bool GraphDBStream::Next(GraphDBLoader &loader)
+  { if (next==count)
+      return false;
+    loader.Read(in, node_size, edge_size);
+    next++;
+    return true;
+  }
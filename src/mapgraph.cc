@@ -0,0 +1,259 @@
+/*--------------------------------------------------------
+ * mapgraph.cc
+ * Implementation of the MappedGraph class
+ * See: mapgraph.h
+ --------------------------------------------------------*/
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "argraph.h"
+#include "mapgraph.h"
+#include "error.h"
+
+
+/*---------------------------------------------------------------
+ * Header of a mapped graph file. The storage block starts at
+ * DATA_OFFSET; it is followed by the hub tables (hub_node,
+ * hub_start and hub_slot, see ARGraph_impl::BuildHubTables),
+ * each starting at a multiple of 8 bytes.
+ --------------------------------------------------------------*/
+struct map_header
+  { char magic[8];
+    unsigned version;
+    unsigned byte_order;
+    unsigned id_size;       /* sizeof(node_id) */
+    unsigned offset_size;   /* size of the edge positions */
+    unsigned pointer_size;  /* sizeof(void*) */
+    unsigned flags;
+    unsigned long long nodes;
+    unsigned long long entries;   /* entries of the 'out' vectors */
+    unsigned long long node_size;
+    unsigned long long edge_size;
+    unsigned long long storage_size;
+    unsigned long long hub_count;
+    unsigned long long hub_slots;
+  };
+
+static const char MAP_MAGIC[8]={ 'V','F','L','I','B','M','A','P' };
+enum { MAP_VERSION=1, MAP_BYTE_ORDER=0x01020304, MAP_UNDIRECTED=1,
+       DATA_OFFSET=128 };
+
+inline size_t align8(size_t bytes)
+  { return (bytes+7) & ~(size_t)7;
+  }
+
+/*---------------------------------------------------------------
+ * Computes the positions in the file of the hub tables, and
+ * returns the size of the file
+ --------------------------------------------------------------*/
+static size_t map_layout(map_header *h, size_t *node_pos,
+                         size_t *start_pos, size_t *slot_pos)
+  { *node_pos=align8(DATA_OFFSET+h->storage_size);
+    *start_pos=align8(*node_pos+h->hub_count*h->id_size);
+    *slot_pos=align8(*start_pos+(h->hub_count+1)*h->offset_size);
+    return *slot_pos+h->hub_slots*sizeof(unsigned);
+  }
+
+/*---------------------------------------------------------------
+ * Writes a block at position pos, followed by zeros up to
+ * the position next_pos, and updates pos
+ --------------------------------------------------------------*/
+static void write_block(std::ostream &out, size_t &pos,
+                        const void *data, size_t size, size_t next_pos)
+  { static const char zeros[DATA_OFFSET]={ 0 };
+    if (size>0)
+      out.write((const char *)data, size);
+    assert(pos+size<=next_pos && next_pos-(pos+size)<DATA_OFFSET);
+    out.write(zeros, next_pos-(pos+size));
+    pos=next_pos;
+  }
+
+
+/*----------------------------------------------------------------
+ * methods of the class MappedGraph
+ ---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Constructor. Maps the file written by MappedGraph::write,
+ * and uses the mapped vectors as they are
+ ---------------------------------------------------------------*/
+MappedGraph::MappedGraph(const char *filename)
+  { map_base=NULL;
+    map_size=0;
+
+    int fd=open(filename, O_RDONLY);
+    if (fd<0)
+      error("MappedGraph: cannot open %s", filename);
+    struct stat st;
+    if (fstat(fd, &st)!=0 || st.st_size<DATA_OFFSET)
+      error("MappedGraph: %s is not a mapped graph file", filename);
+    map_size=st.st_size;
+    void *p=mmap(NULL, map_size, PROT_READ|PROT_WRITE, MAP_PRIVATE,
+                 fd, 0);
+    close(fd);
+    if (p==MAP_FAILED)
+      error("MappedGraph: cannot map %s", filename);
+    map_base=(char *)p;
+
+    map_header *h=(map_header *)map_base;
+    if (memcmp(h->magic, MAP_MAGIC, sizeof(MAP_MAGIC))!=0 ||
+        h->version!=MAP_VERSION)
+      error("MappedGraph: %s is not a mapped graph file", filename);
+    if (h->byte_order!=MAP_BYTE_ORDER || h->id_size!=sizeof(node_id) ||
+        h->offset_size!=sizeof(offset_type) ||
+        h->pointer_size!=sizeof(void*))
+      error("MappedGraph: %s was written for a different platform"
+            " or node_id size", filename);
+
+    n=h->nodes;
+    node_size=h->node_size;
+    edge_size=h->edge_size;
+    undirected=(h->flags & MAP_UNDIRECTED)!=0;
+    offset_type entries=h->entries;
+
+    size_t node_pos, start_pos, slot_pos, file_size;
+    file_size=map_layout(h, &node_pos, &start_pos, &slot_pos);
+    if (h->nodes>=NULL_NODE || entries!=h->entries ||
+        h->storage_size!=StorageSize(n, entries, node_size, edge_size,
+                                     undirected) ||
+        file_size>map_size)
+      error("MappedGraph: %s is corrupted", filename);
+
+    SetStorage(map_base+DATA_OFFSET, entries);
+    out_end=out_start+1;
+    in_end=in_start+1;
+    edge_count=edge_slots=entries;
+    if (out_start[n]!=entries)
+      error("MappedGraph: %s is corrupted", filename);
+
+    hub_count=h->hub_count;
+    if (hub_count>0)
+      { hub_node=(node_id *)(map_base+node_pos);
+        hub_start=(offset_type *)(map_base+start_pos);
+        hub_slot=(unsigned *)(map_base+slot_pos);
+      }
+  }
+
+/*----------------------------------------------------------------
+ * Private constructor, used by write: builds the image of
+ * a graph in an ordinary storage block
+ ---------------------------------------------------------------*/
+MappedGraph::MappedGraph(Graph *g, size_t node_size, size_t edge_size)
+  { map_base=NULL;
+    map_size=0;
+    this->node_size=node_size;
+    this->edge_size=edge_size;
+    undirected=g->IsUndirected();
+    n=g->NodeCount();
+
+    int i, j, k;
+    offset_type edges=0;
+    for(i=0; i<n; i++)
+      edges+=g->OutEdgeCount(i);
+
+    AllocStorage(edges);
+    memset(storage, 0,
+           StorageSize(n, edges, node_size, edge_size, undirected));
+
+    if (node_values!=NULL)
+      for(i=0; i<n; i++)
+        StoreValue(node_values+i*node_size, g->GetNodeAttr(i), node_size);
+
+    offset_type pos=0;
+    for(i=0; i<n; i++)
+      { k=g->OutEdgeCount(i);
+        out_start[i]=pos;
+        for(j=0; j<k; j++, pos++)
+          { void *eattr;
+            out[pos]=g->GetOutEdge(i, j, &eattr);
+            if (edge_values!=NULL)
+              StoreValue(edge_values+pos*edge_size, eattr, edge_size);
+          }
+      }
+    out_start[n]=pos;
+    out_end=out_start+1;
+    in_end=in_start+1;
+    edge_count=edge_slots=edges;
+
+    // An undirected graph already has each edge in both the lists
+    if (!undirected)
+      BuildInEdges();
+    BuildHubTables();
+  }
+
+/*----------------------------------------------------------------
+ * Destructor. The mapped vectors must not be freed by
+ * ARGraph_impl
+ ---------------------------------------------------------------*/
+MappedGraph::~MappedGraph()
+  { if (map_base!=NULL)
+      { hub_node=NULL;
+        hub_start=NULL;
+        hub_slot=NULL;
+        n=0;
+        munmap(map_base, map_size);
+      }
+  }
+
+/*----------------------------------------------------------------
+ * Heap memory used by the graph; the mapped file is not
+ * counted (see MappedSize)
+ ---------------------------------------------------------------*/
+size_t MappedGraph::MemoryUsage()
+  { size_t size=ARGraph_impl::MemoryUsage() +
+                sizeof(MappedGraph)-sizeof(ARGraph_impl);
+    if (map_base!=NULL)
+      size-=HubTablesSize();
+    return size;
+  }
+
+/*----------------------------------------------------------------
+ * Writes a graph in the format read by the constructor.
+ * If node_size (edge_size) is not 0, the first node_size
+ * (edge_size) bytes of each node (edge) attribute are saved,
+ * and the mapped graph will have its attributes stored by
+ * value; otherwise the attributes are not saved.
+ * The stream should be opened in binary mode.
+ ---------------------------------------------------------------*/
+void MappedGraph::write(std::ostream &out, Graph &g,
+                        size_t node_size, size_t edge_size)
+  { MappedGraph image(&g, node_size, edge_size);
+
+    map_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MAP_MAGIC, sizeof(MAP_MAGIC));
+    h.version=MAP_VERSION;
+    h.byte_order=MAP_BYTE_ORDER;
+    h.id_size=sizeof(node_id);
+    h.offset_size=sizeof(offset_type);
+    h.pointer_size=sizeof(void*);
+    h.flags=image.undirected? MAP_UNDIRECTED: 0;
+    h.nodes=image.n;
+    h.entries=image.edge_count;
+    h.node_size=node_size;
+    h.edge_size=edge_size;
+    h.storage_size=StorageSize(image.n, image.edge_count, node_size,
+                               edge_size, image.undirected);
+    h.hub_count=image.hub_count;
+    h.hub_slots=(image.hub_count>0)? image.hub_start[image.hub_count]: 0;
+
+    size_t node_pos, start_pos, slot_pos, file_size;
+    file_size=map_layout(&h, &node_pos, &start_pos, &slot_pos);
+
+    size_t pos=0;
+    write_block(out, pos, &h, sizeof(h), DATA_OFFSET);
+    write_block(out, pos, image.storage, h.storage_size, node_pos);
+    write_block(out, pos, image.hub_node, h.hub_count*sizeof(node_id),
+                start_pos);
+    write_block(out, pos, image.hub_start,
+                (h.hub_count>0)? (h.hub_count+1)*sizeof(offset_type): 0,
+                slot_pos);
+    write_block(out, pos, image.hub_slot, h.hub_slots*sizeof(unsigned),
+                file_size);
+    if (!out)
+      error("MappedGraph::write: write error");
+  }
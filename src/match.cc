@@ -3,16 +3,80 @@
  * Definition of the match function
  ------------------------------------------------------*/
 
+#include <chrono>
+#include <limits.h>
+#ifndef VF_NO_THREADS
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
 #include "argraph.h"
 #include "match.h"
 #include "state.h"
 #include "error.h"
 
 
-static bool match(int *pn, node_id c1[], node_id c2[], State *s);
+/*-------------------------------------------------------------
+ * The limits of a search, and its progress (see limited_match)
+ ------------------------------------------------------------*/
+struct match_budget
+  { long long max_matches;
+    long max_states;
+    double deadline;    /* wall clock time, or 0 */
+    long states;        /* states made so far */
+    long steps;         /* pairs tried so far */
+    int status;
+  };
+
+/* The clock is read once every clock_period pairs tried */
+static const int clock_period=256;
+
+
+static bool match(State *s0, int *pn, node_id c1[], node_id c2[],
+                  match_visitor vis, void *usr_data, long long *pcount,
+                  match_budget *b);
+
+static void init_budget(match_budget *b, const match_limits *limits);
+
+static int max_depth(State *s);
+
+static int int_count(long long count);
+
+static void leave(State *s, bool in_place);
+
+static bool report(State *s, int *pn, node_id c1[], node_id c2[],
+                   match_visitor vis, void *usr_data, long long *pcount,
+                   match_budget *b);
+
+static bool timed_out(match_budget *b);
 
-static bool match(node_id c1[], node_id c2[], match_visitor vis, 
-                 void *usr_data, State *s, int *pcount); 
+static bool take_state(match_budget *b);
+
+static double now();
+
+static void original_ids(State *s, int n, node_id c1[], node_id c2[]);
+
+#ifndef VF_NO_THREADS
+struct match_pool;
+
+static int parallel_search(State *root, match_visitor vis, void *usr_data,
+                           int threads);
+
+static void run_worker(match_pool *p, int w);
+
+static void search_task(match_pool *p, int w, State *s0,
+                        match_frame *stack, node_id c1[], node_id c2[]);
+
+static void add_task(match_pool *p, int w, State *s);
+
+static State *take_task(match_pool *p, int w);
+
+static void end_task(match_pool *p);
+
+static bool visit_locked(int n, node_id c1[], node_id c2[], void *usr_data);
+#endif
 
 
 /*-------------------------------------------------------------
@@ -22,31 +86,26 @@ static bool match(node_id c1[], node_id c2[], match_visitor vis,
  * Returns true a match has been found.
  * *pn is assigned the number of matched nodes, and
  * c1 and c2 will contain the ids of the corresponding nodes 
- * in the two graphs
+ * in the two graphs (the original ids, if a graph has been
+ * relabeled; see relabel.h)
  ------------------------------------------------------------*/
 bool match(State *s0, int *pn, node_id c1[], node_id c2[])
   { 
-    return match(pn,c1,c2,s0);
+    return match(s0, pn, c1, c2, NULL, NULL, NULL, NULL);
   }
 
 /*------------------------------------------------------------
  * int match(s0, vis, usr_data)
  * Visits all the matches between two graphs, given the
  * initial state of the match.
- * Returns the number of visited matches.
+ * Returns the number of visited matches, or INT_MAX if they
+ * do not fit in an int.
  * Stops when there are no more matches, or the visitor vis
  * returns true.
  ----------------------------------------------------------*/
 int match(State *s0, match_visitor vis, void *usr_data)
-  { Graph *g1=s0->GetGraph1();
-    Graph *g2=s0->GetGraph2();
-
-    /* Choose a conservative dimension for the arrays */
-    int n;
-    if (g1->NodeCount()<g2->NodeCount())
-      n=g2->NodeCount();
-    else
-      n=g1->NodeCount();
+  { /* Choose a conservative dimension for the arrays */
+    int n=max_depth(s0);
 
     node_id *c1=new node_id[n];
     node_id *c2=new node_id[n];
@@ -54,92 +113,605 @@ int match(State *s0, match_visitor vis, void *usr_data)
     if (!c1 || !c2)
       error("Out of memory");
 
-    int count=0;
-    match(c1, c2, vis, usr_data, s0, &count);
+    long long count=0;
+    match(s0, NULL, c1, c2, vis, usr_data, &count, NULL);
+
+    delete[] c1;
+    delete[] c2;
+    return int_count(count);
+  }
+
+/*------------------------------------------------------------
+ * int limited_match(s0, vis, usr_data, limits, pcount)
+ * Visits the matches between two graphs as match does,
+ * within the given limits (none if limits is NULL).
+ * Returns the status of the search (MATCH_COMPLETE etc.),
+ * and puts in *pcount, if pcount is not NULL, the number of
+ * visited matches.
+ ----------------------------------------------------------*/
+int limited_match(State *s0, match_visitor vis, void *usr_data,
+                  const match_limits *limits, long long *pcount)
+  { match_budget b;
+    init_budget(&b, limits);
+
+    int n=max_depth(s0);
+    node_id *c1=new node_id[n];
+    node_id *c2=new node_id[n];
+    if (!c1 || !c2)
+      error("Out of memory");
+
+    long long count=0;
+    bool stop=match(s0, NULL, c1, c2, vis, usr_data, &count, &b);
 
     delete[] c1;
     delete[] c2;
+    if (pcount!=NULL)
+      *pcount=count;
+    if (stop && b.status==MATCH_COMPLETE)
+      return MATCH_STOPPED;
+    return b.status;
+  }
+
+/*------------------------------------------------------------
+ * long long match_count(s0, limits, pstatus)
+ * Counts the matches between two graphs, given the initial
+ * state of the match, within the given limits (none if
+ * limits is NULL). The matches are neither extracted from
+ * the states nor passed to a visitor.
+ * Returns the number of matches found, and puts in *pstatus,
+ * if pstatus is not NULL, the status of the search (see
+ * limited_match).
+ ----------------------------------------------------------*/
+long long match_count(State *s0, const match_limits *limits, int *pstatus)
+  { match_budget b;
+    init_budget(&b, limits);
+
+    long long count=0;
+    match(s0, NULL, NULL, NULL, NULL, NULL, &count,
+          (limits!=NULL)? &b: NULL);
+
+    if (pstatus!=NULL)
+      *pstatus=b.status;
     return count;
   }
 
+/*------------------------------------------------------------
+ * int parallel_match(s0, vis, usr_data, threads)
+ * Visits all the matches between two graphs, as match does,
+ * using 'threads' threads, or one for each processor if
+ * threads is 0.
+ * Returns the number of visited matches.
+ ----------------------------------------------------------*/
+int parallel_match(State *s0, match_visitor vis, void *usr_data,
+                   int threads)
+  {
+#ifndef VF_NO_THREADS
+    if (threads<=0)
+      threads=std::thread::hardware_concurrency();
+    State *root=NULL;
+    if (threads>1 && !s0->IsGoal() && !s0->IsDead())
+      root=s0->Fork();
+    if (root!=NULL)
+      return parallel_search(root, vis, usr_data, threads);
+#endif
+    return match(s0, vis, usr_data);
+  }
+
 
 
 /*-------------------------------------------------------------
- * static bool match(pn, c1, c2, s)
- * Finds a matching between two graphs, if it exists, starting
- * from state s.
- * Returns true a match has been found.
- * *pn is assigned the numbero of matched nodes, and
- * c1 and c2 will contain the ids of the corresponding nodes 
- * in the two graphs.
+ * static int max_depth(s)
+ * An upper bound to the number of pairs that can be added
+ * to the state s (i.e. the larger node count of the graphs)
  ------------------------------------------------------------*/
-static bool match(int *pn, node_id c1[], node_id c2[], State *s)
-  { if (s->IsGoal())
-      { 
-        *pn=s->CoreLen();
-        s->GetCoreSet(c1, c2);
-        return true;
-      }
+static int max_depth(State *s)
+  { int n1=s->GetGraph1()->NodeCount();
+    int n2=s->GetGraph2()->NodeCount();
+    return (n1<n2)? n2: n1;
+  }
+
 
-    if (s->IsDead())
+/*-------------------------------------------------------------
+ * static int int_count(count)
+ * The count of matches returned by the functions that return
+ * an int: count itself, or INT_MAX if it does not fit
+ ------------------------------------------------------------*/
+static int int_count(long long count)
+  { return (count>INT_MAX)? INT_MAX: (int)count;
+  }
+
+
+/*-------------------------------------------------------------
+ * static bool match(s0, pn, c1, c2, vis, usr_data, pcount)
+ * Explores the search space depth-first, starting from
+ * state s0.
+ * If c1 is NULL, the matches are only counted in *pcount.
+ * Else if vis is NULL, stops at the first match: *pn is
+ * assigned the number of matched nodes, and c1 and c2 will
+ * contain the ids of the corresponding nodes in the two graphs.
+ * Otherwise each match is passed to vis, and counted in
+ * *pcount, until vis returns true.
+ * If b is not NULL, the search is also stopped when one of
+ * its limits is reached, which is recorded in b->status.
+ * Returns true if the search has been stopped (by a match,
+ * by the visitor, or by a limit).
+ * The visit is iterative: the states along the current path
+ * are kept in a vector allocated at the start, with one level
+ * for each pair that can be added, so the call stack does not
+ * grow with the size of the graphs. The states are cloned,
+ * backtracked and deleted in the same order as by a recursive
+ * visit; if s0 supports PushPair (see state.h), s0 itself is
+ * used at all the levels, and no state is allocated during
+ * the visit.
+ ------------------------------------------------------------*/
+static bool match(State *s0, int *pn, node_id c1[], node_id c2[],
+                  match_visitor vis, void *usr_data, long long *pcount,
+                  match_budget *b)
+  { if (s0->IsGoal())
+      return report(s0, pn, c1, c2, vis, usr_data, pcount, b);
+    if (s0->IsDead())
       return false;
 
-    node_id n1=NULL_NODE, n2=NULL_NODE;
-    bool found=false;
-    while (!found && s->NextPair(&n1, &n2, n1, n2))
-      { if (s->IsFeasiblePair(n1, n2))
-          { State *s1=s->Clone();
-            s1->AddPair(n1, n2);
-            found=match(pn, c1, c2, s1);
-            s1->BackTrack();
-            delete s1;
+    match_frame *stack=new match_frame[max_depth(s0)+1];
+    if (stack==NULL)
+      error("Out of memory");
+    bool in_place=s0->CanPushPair();
+    int top=0;
+    stack[0].s=s0;
+    stack[0].n1=stack[0].n2=NULL_NODE;
+
+    bool stop=false;
+    while (!stop)
+      { match_frame *f=&stack[top];
+        if (!f->s->NextPair(&f->n1, &f->n2, f->n1, f->n2))
+          { // All the pairs of this level have been tried
+            if (top==0)
+              break;
+            leave(f->s, in_place);
+            top--;
+            continue;
+          }
+        if (b!=NULL && timed_out(b))
+          { stop=true;
+            break;
+          }
+        if (!f->s->IsFeasiblePair(f->n1, f->n2))
+          continue;
+        if (b!=NULL && !take_state(b))
+          { stop=true;
+            break;
+          }
+
+        State *s1;
+        if (in_place)
+          { s1=s0;
+            s1->PushPair(f->n1, f->n2);
+          }
+        else
+          { s1=f->s->Clone();
+            s1->AddPair(f->n1, f->n2);
           }
+        if (s1->IsGoal())
+          stop=report(s1, pn, c1, c2, vis, usr_data, pcount, b);
+        else if (!s1->IsDead())
+          { top++;
+            stack[top].s=s1;
+            stack[top].n1=stack[top].n2=NULL_NODE;
+            continue;
+          }
+        leave(s1, in_place);
       }
-    return found;
+
+    // Unwinds the path, if the search has been stopped
+    for(; top>0; top--)
+      leave(stack[top].s, in_place);
+    delete[] stack;
+    return stop;
   }
 
 
+/*-------------------------------------------------------------
+ * static void leave(s, in_place)
+ * Goes back from state s to its parent: removes the last pair
+ * from s if the search is done in place, else discards s.
+ ------------------------------------------------------------*/
+static void leave(State *s, bool in_place)
+  { if (in_place)
+      s->PopPair();
+    else
+      { s->BackTrack();
+        delete s;
+      }
+  }
 
 
 /*-------------------------------------------------------------
- * static bool match(c1, c2, vis, usr_data, pcount)
- * Visits all the matchings between two graphs,  starting
- * from state s.
- * Returns true if the caller must stop the visit.
- * Stops when there are no more matches, or the visitor vis
- * returns true.
+ * static bool report(s, pn, c1, c2, vis, usr_data, pcount, b)
+ * Reports the match found in the goal state s, as described
+ * for match. Returns true if the search must be stopped.
  ------------------------------------------------------------*/
-static bool match(node_id c1[], node_id c2[], 
-                  match_visitor vis, void *usr_data, State *s, int *pcount)
-  { if (s->IsGoal())
-      { ++*pcount;
-        int n=s->CoreLen();
+static bool report(State *s, int *pn, node_id c1[], node_id c2[],
+                   match_visitor vis, void *usr_data, long long *pcount,
+                   match_budget *b)
+  { if (c1==NULL)
+      ++*pcount;
+    else
+      { int n=s->CoreLen();
         s->GetCoreSet(c1, c2);
-        return vis(n, c1, c2, usr_data);
+        original_ids(s, n, c1, c2);
+        if (vis==NULL)
+          { *pn=n;
+            return true;
+          }
+        ++*pcount;
+        if (vis(n, c1, c2, usr_data))
+          return true;
       }
+    if (b!=NULL && b->max_matches>0 && *pcount>=b->max_matches)
+      { b->status=MATCH_MAX_MATCHES;
+        return true;
+      }
+    return false;
+  }
+
 
-    if (s->IsDead())
+/*-------------------------------------------------------------
+ * static void init_budget(b, limits)
+ * Initializes the budget b of a search with the given limits,
+ * which may be NULL
+ ------------------------------------------------------------*/
+static void init_budget(match_budget *b, const match_limits *limits)
+  { b->max_matches=0;
+    b->max_states=0;
+    b->deadline=0;
+    if (limits!=NULL)
+      { b->max_matches=limits->max_matches;
+        b->max_states=limits->max_states;
+        if (limits->max_time>0)
+          b->deadline=now()+limits->max_time;
+      }
+    b->states=b->steps=0;
+    b->status=MATCH_COMPLETE;
+  }
+
+
+/*-------------------------------------------------------------
+ * static bool timed_out(b)
+ * Counts a pair tried by the search with budget b; returns
+ * true if the deadline has passed, checking the clock only
+ * once every clock_period pairs
+ ------------------------------------------------------------*/
+static bool timed_out(match_budget *b)
+  { if (b->deadline==0 || ++b->steps%clock_period!=0)
+      return false;
+    if (now()<b->deadline)
       return false;
+    b->status=MATCH_TIMEOUT;
+    return true;
+  }
 
-    node_id n1=NULL_NODE, n2=NULL_NODE;
-    while (s->NextPair(&n1, &n2, n1, n2))
-      { if (s->IsFeasiblePair(n1, n2))
-          { State *s1=s->Clone();
-            s1->AddPair(n1, n2);
-            if (match(c1, c2, vis, usr_data, s1, pcount))
-              { s1->BackTrack();
-                delete s1;
-                return true;
-              }
+
+/*-------------------------------------------------------------
+ * static bool take_state(b)
+ * Counts a new state made by the search with budget b;
+ * returns false if the maximum number of states has already
+ * been reached
+ ------------------------------------------------------------*/
+static bool take_state(match_budget *b)
+  { if (b->max_states>0 && b->states>=b->max_states)
+      { b->status=MATCH_MAX_STATES;
+        return false;
+      }
+    b->states++;
+    return true;
+  }
+
+
+/*-------------------------------------------------------------
+ * static double now()
+ * Wall clock time, in seconds
+ ------------------------------------------------------------*/
+static double now()
+  { return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+
+/*-------------------------------------------------------------
+ * static void original_ids(s, n, c1, c2)
+ * Translates the ids of a match found in state s to the
+ * original ids of the graphs, for the graphs that have been
+ * relabeled. This is done only when a match is reported, so
+ * the search itself always works on the relabeled ids.
+ ------------------------------------------------------------*/
+static void original_ids(State *s, int n, node_id c1[], node_id c2[])
+  { node_id *map1=s->GetGraph1()->OriginalIds();
+    node_id *map2=s->GetGraph2()->OriginalIds();
+    int i;
+    if (map1!=NULL)
+      for(i=0; i<n; i++)
+        c1[i]=map1[c1[i]];
+    if (map2!=NULL)
+      for(i=0; i<n; i++)
+        c2[i]=map2[c2[i]];
+  }
+
+
+
+#ifndef VF_NO_THREADS
+/*-------------------------------------------------------------
+ *   PARALLEL SEARCH
+ * The search tree is split into tasks, each being a forked
+ * state whose subtree is searched by a single worker thread,
+ * so no state is shared by two threads.
+ * Each worker has a deque of tasks: it takes its own tasks
+ * from the back, depth first, and when it has none it steals
+ * the oldest task of another worker, which is the closest to
+ * the root and so usually the largest one.
+ * The tasks are made during the search: a worker reaching a
+ * state less than split_depth pairs deeper than s0 forks it
+ * into a task of its own, instead of searching it, as long as
+ * fewer than tasks_per_thread tasks per thread are waiting.
+ * So the tree is split at its shallow levels, both at the
+ * start and whenever the workers are running out of tasks.
+ * The deques are protected by a single lock, since tasks are
+ * only made and taken near the root; the visitor has a lock
+ * of its own, and the stop flag is polled by the workers at
+ * each step, without locking.
+ ------------------------------------------------------------*/
+static const int split_depth=8;
+static const int tasks_per_thread=8;
+
+struct match_deque
+  { State **task;
+    int first, last;    /* the tasks are task[first..last-1] */
+    int size;
+  };
+
+struct match_pool
+  { match_visitor vis;
+    void *usr_data;
+    int threads;
+    int depth;          /* max_depth of the states */
+    int split_len;      /* core length up to which tasks are made */
+    match_deque *deque;
+    std::atomic<int> waiting;   /* tasks in the deques */
+    int active;         /* tasks waiting or being searched */
+    long long count;    /* visited matches */
+    std::atomic<bool> stop;
+    std::mutex lock;    /* protects the deques and active */
+    std::mutex visit_lock;  /* protects count, and the visitor */
+    std::condition_variable wake;  /* a task, the end, or stop */
+  };
+
+
+/*-------------------------------------------------------------
+ * static int parallel_search(root, vis, usr_data, threads)
+ * Does the work of parallel_match, starting from root, a
+ * state forked from s0, which is deleted. The calling thread
+ * acts as one of the workers.
+ ------------------------------------------------------------*/
+static int parallel_search(State *root, match_visitor vis, void *usr_data,
+                           int threads)
+  { match_pool p;
+    p.vis=vis;
+    p.usr_data=usr_data;
+    p.threads=threads;
+    p.depth=max_depth(root);
+    p.split_len=root->CoreLen()+split_depth;
+    p.deque=new match_deque[threads];
+    if (p.deque==NULL)
+      error("Out of memory");
+    int i, j;
+    for(i=0; i<threads; i++)
+      { p.deque[i].task=NULL;
+        p.deque[i].first=p.deque[i].last=p.deque[i].size=0;
+      }
+    p.waiting=0;
+    p.active=0;
+    p.count=0;
+    p.stop=false;
+
+    add_task(&p, 0, root);
+    std::thread *thr=new std::thread[threads-1];
+    if (thr==NULL)
+      error("Out of memory");
+    for(i=1; i<threads; i++)
+      thr[i-1]=std::thread(run_worker, &p, i);
+    run_worker(&p, 0);
+    for(i=1; i<threads; i++)
+      thr[i-1].join();
+    delete[] thr;
+
+    // The tasks left if the search has been stopped
+    for(i=0; i<threads; i++)
+      { match_deque *d=&p.deque[i];
+        for(j=d->first; j<d->last; j++)
+          delete d->task[j];
+        delete[] d->task;
+      }
+    delete[] p.deque;
+    return int_count(p.count);
+  }
+
+
+/*-------------------------------------------------------------
+ * static void run_worker(p, w)
+ * Body of the worker w: searches the tasks until there are
+ * no more, or the search is stopped
+ ------------------------------------------------------------*/
+static void run_worker(match_pool *p, int w)
+  { match_frame *stack=new match_frame[p->depth+1];
+    node_id *c1=new node_id[p->depth];
+    node_id *c2=new node_id[p->depth];
+    if (stack==NULL || c1==NULL || c2==NULL)
+      error("Out of memory");
+
+    State *s;
+    while ((s=take_task(p, w))!=NULL)
+      { search_task(p, w, s, stack, c1, c2);
+        delete s;
+        end_task(p);
+      }
+
+    delete[] stack;
+    delete[] c1;
+    delete[] c2;
+  }
+
+
+/*-------------------------------------------------------------
+ * static void search_task(p, w, s0, stack, c1, c2)
+ * Searches the subtree of the task s0 for the worker w, as
+ * the sequential match does, except for making new tasks of
+ * the shallow states (see above). s0 is neither a goal nor
+ * a dead state.
+ ------------------------------------------------------------*/
+static void search_task(match_pool *p, int w, State *s0,
+                        match_frame *stack, node_id c1[], node_id c2[])
+  { bool in_place=s0->CanPushPair();
+    int top=0;
+    stack[0].s=s0;
+    stack[0].n1=stack[0].n2=NULL_NODE;
+
+    long long count=0;
+    while (!p->stop.load(std::memory_order_relaxed))
+      { match_frame *f=&stack[top];
+        if (!f->s->NextPair(&f->n1, &f->n2, f->n1, f->n2))
+          { if (top==0)
+              break;
+            leave(f->s, in_place);
+            top--;
+            continue;
+          }
+        if (!f->s->IsFeasiblePair(f->n1, f->n2))
+          continue;
+
+        State *s1;
+        if (in_place)
+          { s1=s0;
+            s1->PushPair(f->n1, f->n2);
+          }
+        else
+          { s1=f->s->Clone();
+            s1->AddPair(f->n1, f->n2);
+          }
+        if (s1->IsGoal())
+          report(s1, NULL, c1, c2, visit_locked, p, &count, NULL);
+        else if (!s1->IsDead())
+          { if (s1->CoreLen()<p->split_len &&
+                p->waiting.load(std::memory_order_relaxed)<
+                  p->threads*tasks_per_thread)
+              add_task(p, w, s1->Fork());
             else
-	      { s1->BackTrack();
-                delete s1;
-	      }
+              { top++;
+                stack[top].s=s1;
+                stack[top].n1=stack[top].n2=NULL_NODE;
+                continue;
+              }
           }
+        leave(s1, in_place);
+      }
+
+    for(; top>0; top--)
+      leave(stack[top].s, in_place);
+  }
+
+
+/*-------------------------------------------------------------
+ * static void add_task(p, w, s)
+ * Adds the task s at the back of the deque of the worker w
+ ------------------------------------------------------------*/
+static void add_task(match_pool *p, int w, State *s)
+  { std::lock_guard<std::mutex> lk(p->lock);
+    match_deque *d=&p->deque[w];
+    if (d->last==d->size)
+      { int n=d->last-d->first;
+        State **task=d->task;
+        if (n>=d->size/2)
+          { d->size=(d->size==0)? 16: 2*d->size;
+            task=new State*[d->size];
+            if (task==NULL)
+              error("Out of memory");
+          }
+        int i;
+        for(i=0; i<n; i++)
+          task[i]=d->task[d->first+i];
+        if (task!=d->task)
+          { delete[] d->task;
+            d->task=task;
+          }
+        d->first=0;
+        d->last=n;
+      }
+    d->task[d->last++]=s;
+    p->waiting++;
+    p->active++;
+    p->wake.notify_one();
+  }
+
+
+/*-------------------------------------------------------------
+ * static State *take_task(p, w)
+ * Takes a task for the worker w: the newest of its own, or
+ * else the oldest of another worker, waiting if needed.
+ * Returns NULL when there are no more tasks, or the search
+ * has been stopped.
+ ------------------------------------------------------------*/
+static State *take_task(match_pool *p, int w)
+  { std::unique_lock<std::mutex> lk(p->lock);
+    for(;;)
+      { if (p->stop)
+          return NULL;
+        match_deque *d=&p->deque[w];
+        if (d->last>d->first)
+          { p->waiting--;
+            return d->task[--d->last];
+          }
+        int i;
+        for(i=1; i<p->threads; i++)
+          { d=&p->deque[(w+i)%p->threads];
+            if (d->last>d->first)
+              { p->waiting--;
+                return d->task[d->first++];
+              }
+          }
+        if (p->active==0)
+          return NULL;
+        p->wake.wait(lk);
       }
-    return false;
   }
 
 
+/*-------------------------------------------------------------
+ * static void end_task(p)
+ * Called when a task has been searched
+ ------------------------------------------------------------*/
+static void end_task(match_pool *p)
+  { std::lock_guard<std::mutex> lk(p->lock);
+    if (--p->active==0)
+      p->wake.notify_all();
+  }
 
 
+/*-------------------------------------------------------------
+ * static bool visit_locked(n, c1, c2, usr_data)
+ * The visitor passed to report by the workers: calls the
+ * visitor of the pool usr_data, one thread at a time, until
+ * the search is stopped
+ ------------------------------------------------------------*/
+static bool visit_locked(int n, node_id c1[], node_id c2[], void *usr_data)
+  { match_pool *p=(match_pool *)usr_data;
+    std::lock_guard<std::mutex> lk(p->visit_lock);
+    if (p->stop)
+      return true;
+    p->count++;
+    if (p->vis(n, c1, c2, p->usr_data))
+      { // Taking the lock, so no idle worker can miss the wake up
+        std::lock_guard<std::mutex> lk2(p->lock);
+        p->stop=true;
+        p->wake.notify_all();
+      }
+    return p->stop;
+  }
+#endif
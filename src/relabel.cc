@@ -0,0 +1,325 @@
+/*--------------------------------------------------------
+ * relabel.cc
+ * Renumbering of the nodes of a graph to improve the
+ * locality of the matching process.
+ * See: argraph.h, relabel.h
+ --------------------------------------------------------*/
+
+#include <stdlib.h>
+
+#include "argraph.h"
+#include "relabel.h"
+#include "error.h"
+
+
+typedef int (*compare_fn)(const void *, const void *);
+
+struct NodeDegree
+  { node_id id;
+    int deg;
+  };
+
+static void BreadthFirstOrder(Graph *g, node_id *order, bool by_degree);
+static void DegreeOrder(Graph *g, node_id *order);
+static int increasingDegreeComp(NodeDegree *a, NodeDegree *b);
+static int decreasingDegreeComp(NodeDegree *a, NodeDegree *b);
+static int edgeInfoComp(const void *a, const void *b);
+
+
+/*----------------------------------------------------------------
+ * Computes a new order for the nodes of a graph, using one of
+ * the methods described in relabel.h.
+ * Returns a heap-allocated vector (using new) containing, for
+ * each position in the new order, the id of the node in g.
+ ----------------------------------------------------------------*/
+node_id *RelabelingOrder(Graph *g, int method)
+  { int n=g->NodeCount();
+    node_id *order=new node_id[n];
+    if (order==NULL)
+      OUT_OF_MEMORY();
+
+    int i;
+    switch (method)
+      { case RELABEL_BFS:
+          BreadthFirstOrder(g, order, false);
+          break;
+        case RELABEL_RCM:
+          BreadthFirstOrder(g, order, true);
+          for(i=0; i<n/2; i++)
+            { node_id tmp=order[i];
+              order[i]=order[n-1-i];
+              order[n-1-i]=tmp;
+            }
+          break;
+        case RELABEL_DEGREE:
+          DegreeOrder(g, order);
+          break;
+        default:
+          error("RelabelingOrder: unknown method %d", method);
+      }
+    return order;
+  }
+
+
+/*----------------------------------------------------------------
+ * Breadth-first visit of all the components of the graph,
+ * following the edges in both directions.
+ * If by_degree is false, each component is started from its
+ * node with the lowest id, and the neighbors of a node are
+ * enqueued in the order of its edges; otherwise (Cuthill-McKee)
+ * the components are started from a node of minimum degree,
+ * and the neighbors are enqueued by increasing degree.
+ ----------------------------------------------------------------*/
+static void BreadthFirstOrder(Graph *g, node_id *order, bool by_degree)
+  { int n=g->NodeCount();
+    int i, j;
+
+    NodeDegree *start=new NodeDegree[n];
+    bool *visited=new bool[n];
+    if (n>0 && (start==NULL || visited==NULL))
+      OUT_OF_MEMORY();
+
+    int max_deg=0;
+    for(i=0; i<n; i++)
+      { start[i].id=i;
+        start[i].deg=g->EdgeCount(i);
+        if (start[i].deg>max_deg)
+          max_deg=start[i].deg;
+        visited[i]=false;
+      }
+
+    NodeDegree *nbr=NULL;
+    if (by_degree)
+      { qsort(start, n, sizeof(start[0]), (compare_fn)increasingDegreeComp);
+        nbr=new NodeDegree[max_deg+1];
+        if (nbr==NULL)
+          OUT_OF_MEMORY();
+      }
+
+    int head=0, tail=0, s;
+    for(s=0; s<n; s++)
+      { if (visited[start[s].id])
+          continue;
+        visited[start[s].id]=true;
+        order[tail++]=start[s].id;
+
+        while (head<tail)
+          { node_id node=order[head++];
+            int first=tail;
+            for(j=0; j<g->OutEdgeCount(node); j++)
+              { node_id other=g->GetOutEdge(node, j);
+                if (!visited[other])
+                  { visited[other]=true;
+                    order[tail++]=other;
+                  }
+              }
+            for(j=0; j<g->InEdgeCount(node); j++)
+              { node_id other=g->GetInEdge(node, j);
+                if (!visited[other])
+                  { visited[other]=true;
+                    order[tail++]=other;
+                  }
+              }
+
+            if (by_degree && tail-first>1)
+              { int k=tail-first;
+                for(j=0; j<k; j++)
+                  { nbr[j].id=order[first+j];
+                    nbr[j].deg=g->EdgeCount(nbr[j].id);
+                  }
+                qsort(nbr, k, sizeof(nbr[0]),
+                      (compare_fn)increasingDegreeComp);
+                for(j=0; j<k; j++)
+                  order[first+j]=nbr[j].id;
+              }
+          }
+      }
+    assert(tail==n);
+
+    delete[] nbr;
+    delete[] visited;
+    delete[] start;
+  }
+
+
+/*----------------------------------------------------------------
+ * Orders the nodes by decreasing number of edges, so that the
+ * nodes touched most often are close together.
+ ----------------------------------------------------------------*/
+static void DegreeOrder(Graph *g, node_id *order)
+  { int n=g->NodeCount();
+    NodeDegree *vect=new NodeDegree[n];
+    if (n>0 && vect==NULL)
+      OUT_OF_MEMORY();
+
+    int i;
+    for(i=0; i<n; i++)
+      { vect[i].id=i;
+        vect[i].deg=g->EdgeCount(i);
+      }
+    qsort(vect, n, sizeof(vect[0]), (compare_fn)decreasingDegreeComp);
+    for(i=0; i<n; i++)
+      order[i]=vect[i].id;
+
+    delete[] vect;
+  }
+
+
+
+/*----------------------------------------------------------------
+ * methods of the class RelabelLoader
+ ---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Constructor. Builds a graph from the source loader, in order
+ * to compute the new order of the nodes.
+ ---------------------------------------------------------------*/
+RelabelLoader::RelabelLoader(ARGLoader *loader, int method)
+  { g=new Graph(loader);
+    if (g==NULL)
+      OUT_OF_MEMORY();
+
+    int n=g->NodeCount();
+    order=RelabelingOrder(g, method);
+    new_id=new node_id[n];
+    if (n>0 && new_id==NULL)
+      OUT_OF_MEMORY();
+
+    int i, max_deg=0;
+    for(i=0; i<n; i++)
+      { new_id[order[i]]=i;
+        if (g->OutEdgeCount(i)>max_deg)
+          max_deg=g->OutEdgeCount(i);
+      }
+
+    edges=new edge_info[max_deg+1];
+    if (edges==NULL)
+      OUT_OF_MEMORY();
+    cur=-1;
+  }
+
+/*----------------------------------------------------------------
+ * Destructor. The attributes are not destroyed, since they
+ * belong to the relabeled graph.
+ ---------------------------------------------------------------*/
+RelabelLoader::~RelabelLoader()
+  { delete g;
+    delete[] order;
+    delete[] new_id;
+    delete[] edges;
+  }
+
+/*----------------------------------------------------------------
+ * Gives the original ids to a graph built from this loader.
+ * The graph becomes the owner of the permutation, so this
+ * method can be called only once.
+ ---------------------------------------------------------------*/
+void RelabelLoader::AttachTo(Graph *graph)
+  { if (order==NULL)
+      error("RelabelLoader: the original ids have already been given");
+    if (graph->NodeCount()!=g->NodeCount())
+      error("RelabelLoader: the graph was not built from this loader");
+    graph->SetOriginalIds(order);
+    order=NULL;
+  }
+
+int RelabelLoader::NodeCount()
+  { return g->NodeCount();
+  }
+
+void *RelabelLoader::GetNodeAttr(node_id node)
+  { assert(order!=NULL);
+    return g->GetNodeAttr(order[node]);
+  }
+
+int RelabelLoader::OutEdgeCount(node_id node)
+  { assert(order!=NULL);
+    return g->OutEdgeCount(order[node]);
+  }
+
+/*----------------------------------------------------------------
+ * The edges of a node must be given sorted by destination;
+ * the loader keeps the sorted edges of the last node requested,
+ * since ARGraph_impl asks for the edges of a node in sequence.
+ ---------------------------------------------------------------*/
+node_id RelabelLoader::GetOutEdge(node_id node, int i, void **pattr)
+  { if ((int)node!=cur)
+      LoadEdges(node);
+    assert(i<g->OutEdgeCount(order[node]));
+    if (pattr!=NULL)
+      *pattr=edges[i].attr;
+    return edges[i].id;
+  }
+
+void RelabelLoader::GetOutEdges(node_id node, node_id *dest, void **attrs)
+  { if ((int)node!=cur)
+      LoadEdges(node);
+    int i, k=g->OutEdgeCount(order[node]);
+    for(i=0; i<k; i++)
+      { dest[i]=edges[i].id;
+        if (attrs!=NULL)
+          attrs[i]=edges[i].attr;
+      }
+  }
+
+void RelabelLoader::LoadEdges(node_id node)
+  { assert(order!=NULL);
+    node_id old=order[node];
+    int j, k=g->OutEdgeCount(old);
+    for(j=0; j<k; j++)
+      { void *attr;
+        edges[j].id=new_id[g->GetOutEdge(old, j, &attr)];
+        edges[j].attr=attr;
+      }
+    qsort(edges, k, sizeof(edges[0]), edgeInfoComp);
+    cur=node;
+  }
+
+
+
+
+/**
+ * The ordering by increasing degree, then by id
+ */
+static int increasingDegreeComp(NodeDegree *a, NodeDegree *b)
+  { if (a->deg < b->deg)
+      return -1;
+    else if (a->deg > b->deg)
+      return +1;
+    else if (a->id < b->id)
+      return -1;
+    else if (a->id > b->id)
+      return +1;
+    else
+      return 0;
+  }
+
+/**
+ * The ordering by decreasing degree, then by id
+ */
+static int decreasingDegreeComp(NodeDegree *a, NodeDegree *b)
+  { if (a->deg > b->deg)
+      return -1;
+    else if (a->deg < b->deg)
+      return +1;
+    else if (a->id < b->id)
+      return -1;
+    else if (a->id > b->id)
+      return +1;
+    else
+      return 0;
+  }
+
+/**
+ * The ordering of the edges by destination
+ */
+static int edgeInfoComp(const void *a, const void *b)
+  { node_id ia=*(const node_id*)a;
+    node_id ib=*(const node_id*)b;
+    if (ia < ib)
+      return -1;
+    else if (ia > ib)
+      return +1;
+    else
+      return 0;
+  }
@@ -188,11 +188,11 @@ bool SDState::NextPair(node_id *pn1, node_id *pn2,
 
     assert(core1[prev_n1]==NULL_NODE);
 
-    while (prev_n2 < n2 && 
+    while (prev_n2 < (node_id)n2 && 
           (cls1[prev_n1] != cls2[prev_n2] || core2[prev_n2] != NULL_NODE))
       prev_n2 ++;
 
-    if (prev_n2 < n2)
+    if (prev_n2 < (node_id)n2)
       { *pn1 = prev_n1;
         *pn2 = prev_n2;
 	return true;
@@ -210,49 +210,43 @@ bool SDState::NextPair(node_id *pn1, node_id *pn2,
  * semantic attribute compatibility.
  ---------------------------------------------------------*/
 bool SDState::IsFeasiblePair(node_id node1, node_id node2)
-  { if (!g1->CompatibleNode(g1->GetNodeAttr(node1),
-                            g2->GetNodeAttr(node2)))
+  { if (!g1->CompatibleNodes(node1, g2, node2))
       return false;
     int i;
     node_id o1, o2;
-    void *attr1, *attr2;
 
 
     for(i=0; i<g1->OutEdgeCount(node1); i++)
-      { o1=g1->GetOutEdge(node1, i, &attr1);
+      { o1=g1->GetOutEdge(node1, i);
         if ((o2=core1[o1]) != NULL_NODE)
-	  { attr2=g2->GetEdgeAttr(node2, o2);
-	    if (!g1->CompatibleEdge(attr1, attr2))
+	  { if (!g1->CompatibleEdges(node1, o1, g2, node2, o2))
 	      return false;
 	  }
       }
 
 
     for(i=0; i<g2->OutEdgeCount(node2); i++)
-      { o2=g2->GetOutEdge(node2, i, &attr2);
+      { o2=g2->GetOutEdge(node2, i);
         if ((o1=core2[o2]) != NULL_NODE)
-	  { attr1=g1->GetEdgeAttr(node1, o1);
-	    if (!g1->CompatibleEdge(attr1, attr2))
+	  { if (!g1->CompatibleEdges(node1, o1, g2, node2, o2))
 	      return false;
 	  }
       }
 
 
     for(i=0; i<g1->InEdgeCount(node1); i++)
-      { o1=g1->GetInEdge(node1, i, &attr1);
+      { o1=g1->GetInEdge(node1, i);
         if ((o2=core1[o1]) != NULL_NODE)
-	  { attr2=g2->GetEdgeAttr(o2, node2);
-	    if (!g1->CompatibleEdge(attr1, attr2))
+	  { if (!g1->CompatibleEdges(o1, node1, g2, o2, node2))
 	      return false;
 	  }
       }
 
 
     for(i=0; i<g2->InEdgeCount(node2); i++)
-      { o2=g2->GetInEdge(node2, i, &attr2);
+      { o2=g2->GetInEdge(node2, i);
         if ((o1=core2[o2]) != NULL_NODE)
-	  { attr1=g1->GetEdgeAttr(o1, node1);
-	    if (!g1->CompatibleEdge(attr1, attr2))
+	  { if (!g1->CompatibleEdges(o1, node1, g2, o2, node2))
 	      return false;
 	  }
       }
@@ -317,6 +311,44 @@ void SDState::GetCoreSet(node_id c1[], node_id c2[])
 State *SDState::Clone()
   { return new SDState(*this);
   }
+
+/*----------------------------------------------------------------
+ * Heap memory used by the state: each state has its own class
+ * and class count vectors
+ ---------------------------------------------------------------*/
+size_t SDState::MemoryUsage()
+  { if (share_count==NULL)
+      return sizeof(SDState);
+    return sizeof(SDState) + 4*n1*sizeof(node_id);
+  }
+
+/*----------------------------------------------------------------
+ * Heap memory used by the structures shared among the states
+ * of a match: the two distance matrices, the cores and the
+ * work vectors
+ ---------------------------------------------------------------*/
+size_t SDState::SharedMemoryUsage()
+  { if (share_count==NULL)
+      return 0;
+    return 2*n1*(n1*sizeof(node_id)+sizeof(node_id *)) +
+           4*n1*sizeof(node_id) + sizeof(long);
+  }
+
+/*----------------------------------------------------------------
+ * Estimates the peak heap memory used by the states of a match
+ * between graphs with n1 and n2 nodes: the shared structures
+ * (dominated by the n1*n1 distance matrices) and a state for
+ * each level of the search, up to n1 levels below the initial
+ * state. The scratch vectors used while building the initial
+ * state are not included.
+ ---------------------------------------------------------------*/
+size_t SDState::PeakMemoryUsage(int n1, int n2)
+  { if (n1!=n2)
+      return sizeof(SDState);
+    return 2*n1*((size_t)n1*sizeof(node_id)+sizeof(node_id *)) +
+           4*n1*sizeof(node_id) + sizeof(long) +
+           (n1+1)*(sizeof(SDState) + 4*n1*sizeof(node_id));
+  }
   
 
 /*-----------------------------------------------
@@ -344,7 +376,7 @@ static node_id **create_distance_matrix(Graph *g)
   { int i, j, k;
     int n=g->NodeCount();
 
-    assert(n < NULL_NODE);
+    assert((node_id)n < NULL_NODE);
 
     node_id **d;
     d=new node_id *[n];
@@ -422,11 +454,11 @@ static void compute_initial_partition(Graph *g1, Graph *g2,
 	   wrk1[i]=wrk2[i]=0;
          for(i=0; i<n; i++)
 	   for(j=0; j<n; j++)
-	     if (dist1[i][j]==col)
+	     if (dist1[i][j]==(node_id)col)
 	       wrk1[i] ++;
          for(i=0; i<n; i++)
 	   for(j=0; j<n; j++)
-	     if (dist2[i][j]==col)
+	     if (dist2[i][j]==(node_id)col)
 	       wrk2[i] ++;
         
 	 compose_vectors(n, cls1, cls2, wrk1, wrk2, tmp1, tmp2);
@@ -436,11 +468,11 @@ static void compute_initial_partition(Graph *g1, Graph *g2,
 	   wrk1[i]=wrk2[i]=0;
          for(i=0; i<n; i++)
 	   for(j=0; j<n; j++)
-	     if (dist1[j][i]==col)
+	     if (dist1[j][i]==(node_id)col)
 	       wrk1[i] ++;
          for(i=0; i<n; i++)
 	   for(j=0; j<n; j++)
-	     if (dist2[j][i]==col)
+	     if (dist2[j][i]==(node_id)col)
 	       wrk2[i] ++;
         
 	 compose_vectors(n, tmp1, tmp2, wrk1, wrk2, cls1, cls2);
@@ -458,7 +490,7 @@ static void count_classes(node_id *cls, int n, node_id *cnt)
     for(i=0; i<n; i++)
       cnt[i]=0;
     for(i=0; i<n; i++)
-      if (cls[i]<n)
+      if (cls[i]<(node_id)n)
         cnt[cls[i]]++;
   }
 
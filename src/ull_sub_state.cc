@@ -74,7 +74,7 @@ UllSubState::UllSubState(Graph *ag1, Graph *ag2)
       for(j=0; j<n2; j++)
         M[i][j]=(g1->InEdgeCount(i) <= g2->InEdgeCount(j) &&
                  g1->OutEdgeCount(i) <= g2->OutEdgeCount(j)) &&
-                 g1->CompatibleNode(g1->GetNodeAttr(i), g2->GetNodeAttr(j)) ?
+                 g1->CompatibleNodes(i, g2, j) ?
                  1: 0;
 
   }
@@ -152,16 +152,16 @@ bool UllSubState::NextPair(node_id *pn1, node_id *pn2,
     else
       prev_n2++;
 
-    if (prev_n2>=n2)
+    if (prev_n2>=(node_id)n2)
       { prev_n1++;
         prev_n2=0;
       }
 
-    if (prev_n1!=core_len)
+    if (prev_n1!=(node_id)core_len)
       return false;
-    while (prev_n2<n2 && M[prev_n1][prev_n2]==0)
+    while (prev_n2<(node_id)n2 && M[prev_n1][prev_n2]==0)
       prev_n2++;
-    if (prev_n2<n2)
+    if (prev_n2<(node_id)n2)
       { *pn1=prev_n1;
         *pn2=prev_n2;
         return true;
@@ -177,8 +177,8 @@ bool UllSubState::NextPair(node_id *pn1, node_id *pn2,
  * Returns true if (node1, node2) can be added to the state
  --------------------------------------------------------------*/
 bool UllSubState::IsFeasiblePair(node_id node1, node_id node2)
-  { assert(node1<n1);
-    assert(node2<n2);
+  { assert(node1<(node_id)n1);
+    assert(node2<(node_id)n2);
 
     return M[node1][node2]!=0;
   }
@@ -191,8 +191,8 @@ bool UllSubState::IsFeasiblePair(node_id node1, node_id node2)
  * Precondition: the pair must be feasible
  -------------------------------------------------------------*/
 void UllSubState::AddPair(node_id node1, node_id node2)
-  { assert(node1<n1);
-    assert(node2<n2);
+  { assert(node1<(node_id)n1);
+    assert(node2<(node_id)n2);
     assert(core_len<n1);
     assert(core_len<n2);
 
@@ -245,7 +245,7 @@ void UllSubState::refine()
             //for(k=0; k<core_len; k++)
 			for(k=core_len-1; k<core_len; k++)
               { l=core_1[k];
-                assert(l!=NULL_NODE);
+                assert((node_id)l!=NULL_NODE);
                 edge_ik=g1->HasEdge(i,k);
                 edge_ki=g1->HasEdge(k,i);
                 edge_jl=g2->HasEdge(j,l);
@@ -255,14 +255,12 @@ void UllSubState::refine()
                     break;
                   }
                 else if (edge_ik  &&
-                         !g1->CompatibleEdge(g1->GetEdgeAttr(i,k),
-                                             g2->GetEdgeAttr(j,l)))
+                         !g1->CompatibleEdges(i, k, g2, j, l))
                   { M[i][j]=0;
                     break;
                   }
                 else if (edge_ki  &&
-                         !g1->CompatibleEdge(g1->GetEdgeAttr(k,i),
-                                             g2->GetEdgeAttr(l,j)))
+                         !g1->CompatibleEdges(k, i, g2, l, j))
                   { M[i][j]=0;
                     break;
                   }
@@ -278,3 +276,33 @@ State* UllSubState::Clone()
   { return new UllSubState(*this);
   }
 
+/*----------------------------------------------------------------
+ * Heap memory used by the state: each state has its own core
+ * vectors, and its own copy of the rows of the matrix M that
+ * are still needed (the ones of the nodes not yet in the core
+ * when the state was cloned)
+ --------------------------------------------------------------*/
+size_t UllSubState::MemoryUsage()
+  { size_t size=sizeof(UllSubState) + (n1+n2)*sizeof(node_id) + 
+                n1*sizeof(byte *);
+    int i;
+    for(i=0; i<n1; i++)
+      if (M[i]!=NULL)
+        size+=n2;
+    return size;
+  }
+
+/*----------------------------------------------------------------
+ * Estimates the peak heap memory used by the states of a match
+ * between graphs with n1 and n2 nodes: the search keeps a state
+ * for each level, up to n1 levels below the initial state,
+ * and the state at level k has n1-k+1 rows of M
+ --------------------------------------------------------------*/
+size_t UllSubState::PeakMemoryUsage(int n1, int n2)
+  { size_t rows=n1 + (size_t)n1*(n1+1)/2;
+    return (n1+1)*(sizeof(UllSubState) + (n1+n2)*sizeof(node_id) + 
+                   n1*sizeof(byte *)) +
+           rows*n2;
+  }
+
+
@@ -29,6 +29,8 @@
  * of the core or of Tin (for in_*) or Tout (for out_*),
  * or 0 if the node does not belong to the set.
  * This information is used for backtracking.
+ * Fork makes a state with its own copy of the vectors
+ * (see Unshare), which starts a new group of sharing states.
  * The fields t1out_len etc. also count the nodes in core.
  * The true t1out_len is t1out_len-core_len!
  ---------------------------------------------------------*/
@@ -42,6 +44,21 @@
 #include "error.h"
 
 
+/*----------------------------------------------------------
+ * Returns a copy of the vector v of n nodes, allocated
+ * with new
+ ---------------------------------------------------------*/
+static node_id *copy_vector(node_id *v, int n)
+  { node_id *w=new node_id[n];
+    if (w==NULL)
+      error("Out of memory");
+    int i;
+    for(i=0; i<n; i++)
+      w[i]=v[i];
+    return w;
+  }
+
+
 /*----------------------------------------------------------
  * Methods of the class VF2SubState
  ---------------------------------------------------------*/
@@ -57,6 +74,7 @@ VF2SubState::VF2SubState(Graph *ag1, Graph *ag2, bool sortNodes)
     g2=ag2;
     n1=g1->NodeCount();
     n2=g2->NodeCount();
+    sig_mask=ARGraph_impl::SignatureMask(g1, g2);
 
     if (sortNodes)
       order = SortNodesByFrequency(ag1);
@@ -68,6 +86,7 @@ VF2SubState::VF2SubState(Graph *ag1, Graph *ag2, bool sortNodes)
     t2both_len=t2in_len=t2out_len=0;
 
 	added_node1=NULL_NODE;
+    pushed=NULL;
 
     core_1=new node_id[n1];
     core_2=new node_id[n2];
@@ -107,6 +126,7 @@ VF2SubState::VF2SubState(const VF2SubState &state)
     g2=state.g2;
     n1=state.n1;
     n2=state.n2;
+    sig_mask=state.sig_mask;
 
     order=state.order;
 
@@ -119,6 +139,7 @@ VF2SubState::VF2SubState(const VF2SubState &state)
     t2both_len=state.t2both_len;
 
 	added_node1=NULL_NODE;
+    pushed=NULL;
 
     core_1=state.core_1;
     core_2=state.core_2;
@@ -138,7 +159,8 @@ VF2SubState::VF2SubState(const VF2SubState &state)
  * Destructor.
  --------------------------------------------------------------*/
 VF2SubState::~VF2SubState() 
-  { if (-- *share_count == 0)
+  { delete [] pushed;
+    if (-- *share_count == 0)
     { delete [] core_1;
       delete [] core_2;
       delete [] in_1;
@@ -169,7 +191,7 @@ bool VF2SubState::NextPair(node_id *pn1, node_id *pn2,
       prev_n2++;
 
 	if (t1both_len>core_len && t2both_len>core_len)
-	  { while (prev_n1<n1 &&
+	  { while (prev_n1<(node_id)n1 &&
            (core_1[prev_n1]!=NULL_NODE || out_1[prev_n1]==0
 		            || in_1[prev_n1]==0) )
           { prev_n1++;    
@@ -177,14 +199,14 @@ bool VF2SubState::NextPair(node_id *pn1, node_id *pn2,
           }
 	  }
 	else if (t1out_len>core_len && t2out_len>core_len)
-	  { while (prev_n1<n1 &&
+	  { while (prev_n1<(node_id)n1 &&
            (core_1[prev_n1]!=NULL_NODE || out_1[prev_n1]==0) )
           { prev_n1++;    
             prev_n2=0;
           }
 	  }
     else if (t1in_len>core_len && t2in_len>core_len)
-	  { while (prev_n1<n1 &&
+	  { while (prev_n1<(node_id)n1 &&
            (core_1[prev_n1]!=NULL_NODE || in_1[prev_n1]==0) )
           { prev_n1++;    
             prev_n2=0;
@@ -198,7 +220,7 @@ bool VF2SubState::NextPair(node_id *pn1, node_id *pn2,
 	      prev_n1=n1;
 	  }
 	else
-	  { while (prev_n1<n1 && core_1[prev_n1]!=NULL_NODE )
+	  { while (prev_n1<(node_id)n1 && core_1[prev_n1]!=NULL_NODE )
           { prev_n1++;    
             prev_n2=0;
           }
@@ -207,32 +229,32 @@ bool VF2SubState::NextPair(node_id *pn1, node_id *pn2,
 
 
 	if (t1both_len>core_len && t2both_len>core_len)
-	  { while (prev_n2<n2 &&
+	  { while (prev_n2<(node_id)n2 &&
            (core_2[prev_n2]!=NULL_NODE || out_2[prev_n2]==0
 		            || in_2[prev_n2]==0) )
           { prev_n2++;    
           }
 	  }
 	else if (t1out_len>core_len && t2out_len>core_len)
-	  { while (prev_n2<n2 &&
+	  { while (prev_n2<(node_id)n2 &&
            (core_2[prev_n2]!=NULL_NODE || out_2[prev_n2]==0) )
           { prev_n2++;    
           }
 	  }
     else if (t1in_len>core_len && t2in_len>core_len)
-	  { while (prev_n2<n2 &&
+	  { while (prev_n2<(node_id)n2 &&
            (core_2[prev_n2]!=NULL_NODE || in_2[prev_n2]==0) )
           { prev_n2++;    
           }
 	  }
 	else
-	  { while (prev_n2<n2 && core_2[prev_n2]!=NULL_NODE )
+	  { while (prev_n2<(node_id)n2 && core_2[prev_n2]!=NULL_NODE )
           { prev_n2++;    
           }
 	  }
 	  
 
-    if (prev_n1<n1 && prev_n2<n2)
+    if (prev_n1<(node_id)n1 && prev_n2<(node_id)n2)
           { *pn1=prev_n1;
             *pn2=prev_n2;
             return true;
@@ -255,25 +277,29 @@ bool VF2SubState::NextPair(node_id *pn1, node_id *pn2,
  *   criterion is not symmetric.
  --------------------------------------------------------------*/
 bool VF2SubState::IsFeasiblePair(node_id node1, node_id node2)
-  { assert(node1<n1);
-    assert(node2<n2);
+  { assert(node1<(node_id)n1);
+    assert(node2<(node_id)n2);
     assert(core_1[node1]==NULL_NODE);
     assert(core_2[node2]==NULL_NODE);
 
-    if (!g1->CompatibleNode(g1->GetNodeAttr(node1), g2->GetNodeAttr(node2)))
+    if (sig_mask!=0 &&
+        !ARGraph_impl::SubSignature(g1->NodeSignature(node1),
+                                    g2->NodeSignature(node2), sig_mask))
       return false;
 
-    int i, other1, other2;
-    void *attr1;
+    if (!g1->CompatibleNodes(node1, g2, node2))
+      return false;
+
+    int i;
+    node_id other1, other2;
     int termout1=0, termout2=0, termin1=0, termin2=0, new1=0, new2=0;
 
     // Check the 'out' edges of node1
     for(i=0; i<g1->OutEdgeCount(node1); i++)
-      { other1=g1->GetOutEdge(node1, i, &attr1);
+      { other1=g1->GetOutEdge(node1, i);
         if (core_1[other1] != NULL_NODE)
           { other2=core_1[other1];
-            if (!g2->HasEdge(node2, other2) ||
-                !g1->CompatibleEdge(attr1, g2->GetEdgeAttr(node2, other2)))
+            if (!g1->CompatibleOutEdge(node1, i, g2, node2, other2))
               return false;
           }
         else 
@@ -288,11 +314,10 @@ bool VF2SubState::IsFeasiblePair(node_id node1, node_id node2)
 
     // Check the 'in' edges of node1
     for(i=0; i<g1->InEdgeCount(node1); i++)
-      { other1=g1->GetInEdge(node1, i, &attr1);
+      { other1=g1->GetInEdge(node1, i);
         if (core_1[other1]!=NULL_NODE)
           { other2=core_1[other1];
-            if (!g2->HasEdge(other2, node2) ||
-                !g1->CompatibleEdge(attr1, g2->GetEdgeAttr(other2, node2)))
+            if (!g1->CompatibleInEdge(node1, i, g2, other2, node2))
               return false;
           }
         else 
@@ -353,8 +378,8 @@ bool VF2SubState::IsFeasiblePair(node_id node1, node_id node2)
  * Precondition: the pair must be feasible
  -------------------------------------------------------------*/
 void VF2SubState::AddPair(node_id node1, node_id node2)
-  { assert(node1<n1);
-    assert(node2<n2);
+  { assert(node1<(node_id)n1);
+    assert(node2<(node_id)n2);
     assert(core_len<n1);
     assert(core_len<n2);
 
@@ -391,7 +416,8 @@ void VF2SubState::AddPair(node_id node1, node_id node2)
     core_2[node2]=node1;
 
 
-    int i, other;
+    int i;
+    node_id other;
     for(i=0; i<g1->InEdgeCount(node1); i++)
       { other=g1->GetInEdge(node1, i);
         if (!in_1[other])
@@ -459,6 +485,60 @@ State* VF2SubState::Clone()
   { return new VF2SubState(*this);
   }
 
+/*----------------------------------------------------------------
+ * Makes a copy of the state that does not share its vectors
+ * with this state, allocating it with new (see state.h)
+ --------------------------------------------------------------*/
+State* VF2SubState::Fork()
+  { VF2SubState *s=new VF2SubState(*this);
+    s->Unshare();
+    return s;
+  }
+
+/*----------------------------------------------------------------
+ * Gives the state its own copy of the shared vectors, with
+ * their current contents
+ --------------------------------------------------------------*/
+void VF2SubState::Unshare()
+  { if (*share_count==1)
+      return;
+    -- *share_count;
+    share_count=new long;
+    if (share_count==NULL)
+      error("Out of memory");
+    *share_count=1;
+
+    core_1=copy_vector(core_1, n1);
+    core_2=copy_vector(core_2, n2);
+    in_1=copy_vector(in_1, n1);
+    in_2=copy_vector(in_2, n2);
+    out_1=copy_vector(out_1, n1);
+    out_2=copy_vector(out_2, n2);
+    if (order!=NULL)
+      order=copy_vector(order, n1);
+  }
+
+/*----------------------------------------------------------------
+ * Heap memory used by the vectors shared among the states
+ * of a match (the state itself holds no vectors)
+ --------------------------------------------------------------*/
+size_t VF2SubState::SharedMemoryUsage()
+  { return 3*(n1+n2)*sizeof(node_id) + sizeof(long) +
+           (order!=NULL? n1*sizeof(node_id): 0);
+  }
+
+/*----------------------------------------------------------------
+ * Estimates the peak heap memory used by the states of a match
+ * between graphs with n1 and n2 nodes: the shared vectors 
+ * (including the node order), and a single state, with the
+ * data saved by PushPair for up to n1 levels (see match.cc)
+ --------------------------------------------------------------*/
+size_t VF2SubState::PeakMemoryUsage(int n1, int n2)
+  { return 3*(n1+n2)*sizeof(node_id) + sizeof(long) + 
+           n1*sizeof(node_id) + sizeof(VF2SubState) + n1*sizeof(pushed_pair);
+  }
+
+
 /*----------------------------------------------------------------
  * Undoes the changes to the shared vectors made by the 
  * current state. Assumes that at most one AddPair has been
@@ -467,49 +547,90 @@ State* VF2SubState::Clone()
 void VF2SubState::BackTrack()
   { assert(core_len - orig_core_len <= 1);
     assert(added_node1 != NULL_NODE);
-  
+
     if (orig_core_len < core_len)
-      { int i, node2;
-
-        if (in_1[added_node1] == core_len)
-		  in_1[added_node1] = 0;
-	    for(i=0; i<g1->InEdgeCount(added_node1); i++)
-		  { int other=g1->GetInEdge(added_node1, i);
-		    if (in_1[other]==core_len)
-			  in_1[other]=0;
-		  }
-        
-		if (out_1[added_node1] == core_len)
-		  out_1[added_node1] = 0;
-	    for(i=0; i<g1->OutEdgeCount(added_node1); i++)
-		  { int other=g1->GetOutEdge(added_node1, i);
-		    if (out_1[other]==core_len)
-			  out_1[other]=0;
-		  }
-	    
-		node2 = core_1[added_node1];
-
-        if (in_2[node2] == core_len)
-		  in_2[node2] = 0;
-	    for(i=0; i<g2->InEdgeCount(node2); i++)
-		  { int other=g2->GetInEdge(node2, i);
-		    if (in_2[other]==core_len)
-			  in_2[other]=0;
-		  }
-        
-		if (out_2[node2] == core_len)
-		  out_2[node2] = 0;
-	    for(i=0; i<g2->OutEdgeCount(node2); i++)
-		  { int other=g2->GetOutEdge(node2, i);
-		    if (out_2[other]==core_len)
-			  out_2[other]=0;
-		  }
-	    
-	    core_1[added_node1] = NULL_NODE;
-		core_2[node2] = NULL_NODE;
-	    
-	    core_len=orig_core_len;
-		added_node1 = NULL_NODE;
-	  }
+      { UndoPair(added_node1);
+        core_len=orig_core_len;
+        added_node1 = NULL_NODE;
+      }
+  }
+
+/*----------------------------------------------------------------
+ * Undoes the changes to the shared vectors made by the last
+ * pair added, (node1, core_1[node1]), at level core_len
+ ----------------------------------------------------------------*/
+void VF2SubState::UndoPair(node_id node1)
+  { int i;
+    node_id node2;
+    if (in_1[node1] == (node_id)core_len)
+      in_1[node1] = 0;
+    for(i=0; i<g1->InEdgeCount(node1); i++)
+      { node_id other=g1->GetInEdge(node1, i);
+        if (in_1[other]==(node_id)core_len)
+          in_1[other]=0;
+      }
+    if (out_1[node1] == (node_id)core_len)
+      out_1[node1] = 0;
+    for(i=0; i<g1->OutEdgeCount(node1); i++)
+      { node_id other=g1->GetOutEdge(node1, i);
+        if (out_1[other]==(node_id)core_len)
+          out_1[other]=0;
+      }
+    node2 = core_1[node1];
+    if (in_2[node2] == (node_id)core_len)
+      in_2[node2] = 0;
+    for(i=0; i<g2->InEdgeCount(node2); i++)
+      { node_id other=g2->GetInEdge(node2, i);
+        if (in_2[other]==(node_id)core_len)
+          in_2[other]=0;
+      }
+    if (out_2[node2] == (node_id)core_len)
+      out_2[node2] = 0;
+    for(i=0; i<g2->OutEdgeCount(node2); i++)
+      { node_id other=g2->GetOutEdge(node2, i);
+        if (out_2[other]==(node_id)core_len)
+          out_2[other]=0;
+      }
+    core_1[node1] = NULL_NODE;
+    core_2[node2] = NULL_NODE;
+  }
 
+/*----------------------------------------------------------------
+ * Adds a pair to the state itself, saving what is needed
+ * to remove it with PopPair.
+ ----------------------------------------------------------------*/
+void VF2SubState::PushPair(node_id node1, node_id node2)
+  { assert(core_len<n1);
+    if (pushed==NULL)
+      { pushed=new pushed_pair[n1];
+        if (pushed==NULL)
+          error("Out of memory");
+      }
+    pushed_pair *p=&pushed[core_len];
+    p->node1=node1;
+    p->added_node1=added_node1;
+    p->t1both_len=t1both_len;
+    p->t2both_len=t2both_len;
+    p->t1in_len=t1in_len;
+    p->t1out_len=t1out_len;
+    p->t2in_len=t2in_len;
+    p->t2out_len=t2out_len;
+    AddPair(node1, node2);
+  }
+
+/*----------------------------------------------------------------
+ * Removes the last pair added by PushPair
+ ----------------------------------------------------------------*/
+void VF2SubState::PopPair()
+  { assert(pushed!=NULL && core_len>0);
+    pushed_pair *p=&pushed[core_len-1];
+    UndoPair(p->node1);
+    core_len--;
+    added_node1=p->added_node1;
+    t1both_len=p->t1both_len;
+    t2both_len=p->t2both_len;
+    t1in_len=p->t1in_len;
+    t1out_len=p->t1out_len;
+    t2in_len=p->t2in_len;
+    t2out_len=p->t2out_len;
   }
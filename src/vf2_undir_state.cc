@@ -0,0 +1,512 @@
+/*------------------------------------------------------------------
+ * vf2_undir_state.cc
+ * Implementation of the class template VF2UndirStateBase
+ *
+ *-----------------------------------------------------------------*/
+
+
+
+/*-----------------------------------------------------------------
+ * NOTE:
+ *   The attribute compatibility check (methods CompatibleNode
+ *   and CompatibleEdge of ARGraph) is always performed
+ *   applying the method to g1, and passing the attribute of
+ *   g1 as first argument, and the attribute of g2 as second
+ *   argument. This may be important if the compatibility
+ *   criterion is not symmetric.
+ -----------------------------------------------------------------*/
+
+
+/*---------------------------------------------------------
+ *   IMPLEMENTATION NOTES:
+ * The four vectors core_1, core_2, term_1, term_2 are shared
+ * among the instances of this class; they are owned by the
+ * instance with core_len==0 (the root of the SSR).
+ * In the vectors term_* there is a value indicating the level
+ * at which the corresponding node became a member of the core
+ * or of T (the set of the neighbors of the core), or 0 if the
+ * node does not belong to the set.
+ * This information is used for backtracking.
+ * Fork makes a state with its own copy of the vectors
+ * (see Unshare), which starts a new group of sharing states.
+ * The fields t1_len and t2_len also count the nodes in core.
+ * The true t1_len is t1_len-core_len!
+ ---------------------------------------------------------*/
+
+
+#include <stddef.h>
+
+#include "vf2_undir_state.h"
+
+#include "error.h"
+
+#include "sortnodes.h"
+
+
+/*----------------------------------------------------------
+ * Returns a copy of the vector v of n nodes, allocated
+ * with new
+ ---------------------------------------------------------*/
+static node_id *copy_vector(node_id *v, int n)
+  { node_id *w=new node_id[n];
+    if (w==NULL)
+      error("Out of memory");
+    int i;
+    for(i=0; i<n; i++)
+      w[i]=v[i];
+    return w;
+  }
+
+
+/*----------------------------------------------------------
+ * Methods of the class VF2UndirStateBase
+ ---------------------------------------------------------*/
+
+/*----------------------------------------------------------
+ * VF2UndirStateBase::VF2UndirStateBase(g1, g2, sortNodes)
+ * Constructor. Makes an empty state.
+ * If sortNodes is true, computes an initial ordering
+ * for the nodes based on the frequency of their valence.
+ ---------------------------------------------------------*/
+template <int kind>
+VF2UndirStateBase<kind>::VF2UndirStateBase(Graph *ag1, Graph *ag2,
+                                           bool sortNodes)
+  { g1=ag1;
+    g2=ag2;
+    n1=g1->NodeCount();
+    n2=g2->NodeCount();
+    sig_mask=ARGraph_impl::SignatureMask(g1, g2);
+
+    if (!g1->IsUndirected() || !g2->IsUndirected())
+      error("VF2UndirState: the graphs must be undirected");
+
+    if (sortNodes)
+      order=SortNodesByFrequency(ag1);
+    else
+      order=NULL;
+
+    core_len=orig_core_len=0;
+    t1_len=t2_len=0;
+
+    added_node1=NULL_NODE;
+    pushed=NULL;
+
+    core_1=new node_id[n1];
+    core_2=new node_id[n2];
+    term_1=new node_id[n1];
+    term_2=new node_id[n2];
+    share_count = new long;
+    if (!core_1 || !core_2 || !term_1 || !term_2 || !share_count)
+      error("Out of memory");
+
+    int i;
+    for(i=0; i<n1; i++)
+      { core_1[i]=NULL_NODE;
+        term_1[i]=0;
+      }
+    for(i=0; i<n2; i++)
+      { core_2[i]=NULL_NODE;
+        term_2[i]=0;
+      }
+
+    *share_count = 1;
+  }
+
+
+/*----------------------------------------------------------
+ * VF2UndirStateBase::VF2UndirStateBase(state)
+ * Copy constructor.
+ ---------------------------------------------------------*/
+template <int kind>
+VF2UndirStateBase<kind>::VF2UndirStateBase(const VF2UndirStateBase &state)
+  { g1=state.g1;
+    g2=state.g2;
+    n1=state.n1;
+    n2=state.n2;
+    sig_mask=state.sig_mask;
+
+    order=state.order;
+
+    core_len=orig_core_len=state.core_len;
+    t1_len=state.t1_len;
+    t2_len=state.t2_len;
+
+    added_node1=NULL_NODE;
+    pushed=NULL;
+
+    core_1=state.core_1;
+    core_2=state.core_2;
+    term_1=state.term_1;
+    term_2=state.term_2;
+    share_count=state.share_count;
+
+    ++ *share_count;
+  }
+
+
+/*---------------------------------------------------------------
+ * VF2UndirStateBase::~VF2UndirStateBase()
+ * Destructor.
+ --------------------------------------------------------------*/
+template <int kind>
+VF2UndirStateBase<kind>::~VF2UndirStateBase()
+  { delete [] pushed;
+    if (-- *share_count == 0)
+      { delete [] core_1;
+        delete [] core_2;
+        delete [] term_1;
+        delete [] term_2;
+        delete share_count;
+
+        delete [] order;
+      }
+  }
+
+
+/*--------------------------------------------------------------------------
+ * bool VF2UndirStateBase::NextPair(pn1, pn2, prev_n1, prev_n2)
+ * Puts in *pn1, *pn2 the next pair of nodes to be tried.
+ * prev_n1 and prev_n2 must be the last nodes, or NULL_NODE (default)
+ * to start from the first pair.
+ * Returns false if no more pairs are available.
+ -------------------------------------------------------------------------*/
+template <int kind>
+bool VF2UndirStateBase<kind>::NextPair(node_id *pn1, node_id *pn2,
+                                       node_id prev_n1, node_id prev_n2)
+  { if (prev_n1==NULL_NODE)
+      prev_n1=0;
+
+    if (prev_n2==NULL_NODE)
+      prev_n2=0;
+    else
+      prev_n2++;
+
+    bool use_term=(t1_len>core_len && t2_len>core_len);
+
+    if (use_term)
+      { while (prev_n1<(node_id)n1 &&
+               (core_1[prev_n1]!=NULL_NODE || term_1[prev_n1]==0))
+          { prev_n1++;
+            prev_n2=0;
+          }
+      }
+    else if (prev_n1==0 && order!=NULL)
+      { int i=0;
+        while (i<n1 && core_1[prev_n1=order[i]]!=NULL_NODE)
+          i++;
+        if (i==n1)
+          prev_n1=n1;
+      }
+    else
+      { while (prev_n1<(node_id)n1 && core_1[prev_n1]!=NULL_NODE)
+          { prev_n1++;
+            prev_n2=0;
+          }
+      }
+
+    if (use_term)
+      { while (prev_n2<(node_id)n2 &&
+               (core_2[prev_n2]!=NULL_NODE || term_2[prev_n2]==0))
+          prev_n2++;
+      }
+    else
+      { while (prev_n2<(node_id)n2 && core_2[prev_n2]!=NULL_NODE)
+          prev_n2++;
+      }
+
+    if (prev_n1<(node_id)n1 && prev_n2<(node_id)n2)
+      { *pn1=prev_n1;
+        *pn2=prev_n2;
+        return true;
+      }
+
+    return false;
+  }
+
+
+
+/*---------------------------------------------------------------
+ * bool VF2UndirStateBase::IsFeasiblePair(node1, node2)
+ * Returns true if (node1, node2) can be added to the state.
+ * The edges of node2 towards the core are checked only for
+ * isomorphism and graph-subgraph isomorphism.
+ --------------------------------------------------------------*/
+template <int kind>
+bool VF2UndirStateBase<kind>::IsFeasiblePair(node_id node1, node_id node2)
+  { assert(node1<(node_id)n1);
+    assert(node2<(node_id)n2);
+    assert(core_1[node1]==NULL_NODE);
+    assert(core_2[node2]==NULL_NODE);
+
+    if (sig_mask!=0)
+      { ARGraph_impl::signature_type s1=g1->NodeSignature(node1);
+        ARGraph_impl::signature_type s2=g2->NodeSignature(node2);
+        if (kind==VF2_ISOMORPHISM? 
+               !ARGraph_impl::SameSignature(s1, s2, sig_mask):
+               !ARGraph_impl::SubSignature(s1, s2, sig_mask))
+          return false;
+      }
+
+    if (!g1->CompatibleNodes(node1, g2, node2))
+      return false;
+
+    int i;
+    node_id other1, other2;
+    int term1=0, term2=0, new1=0, new2=0;
+
+    // Check the edges of node1
+    for(i=0; i<g1->OutEdgeCount(node1); i++)
+      { other1=g1->GetOutEdge(node1, i);
+        if (core_1[other1] != NULL_NODE)
+          { other2=core_1[other1];
+            if (!g1->CompatibleOutEdge(node1, i, g2, node2, other2))
+              return false;
+          }
+        else if (term_1[other1])
+          term1++;
+        else
+          new1++;
+      }
+
+    // Check the edges of node2
+    for(i=0; i<g2->OutEdgeCount(node2); i++)
+      { other2=g2->GetOutEdge(node2, i);
+        if (core_2[other2]!=NULL_NODE)
+          { other1=core_2[other2];
+            if (kind!=VF2_MONOMORPHISM && !g1->HasEdge(node1, other1))
+              return false;
+          }
+        else if (term_2[other2])
+          term2++;
+        else
+          new2++;
+      }
+
+    if (kind==VF2_ISOMORPHISM)
+      return term1==term2 && new1==new2;
+    else if (kind==VF2_SUBGRAPH)
+      return term1<=term2 && new1<=new2;
+    else
+      return term1<=term2 && (term1+new1)<=(term2+new2);
+  }
+
+
+
+/*--------------------------------------------------------------
+ * void VF2UndirStateBase::AddPair(node1, node2)
+ * Adds a pair to the Core set of the state.
+ * Precondition: the pair must be feasible
+ -------------------------------------------------------------*/
+template <int kind>
+void VF2UndirStateBase<kind>::AddPair(node_id node1, node_id node2)
+  { assert(node1<(node_id)n1);
+    assert(node2<(node_id)n2);
+    assert(core_len<n1);
+    assert(core_len<n2);
+
+    core_len++;
+    added_node1=node1;
+
+    if (!term_1[node1])
+      { term_1[node1]=core_len;
+        t1_len++;
+      }
+    if (!term_2[node2])
+      { term_2[node2]=core_len;
+        t2_len++;
+      }
+
+    core_1[node1]=node2;
+    core_2[node2]=node1;
+
+    int i;
+    node_id other;
+    for(i=0; i<g1->OutEdgeCount(node1); i++)
+      { other=g1->GetOutEdge(node1, i);
+        if (!term_1[other])
+          { term_1[other]=core_len;
+            t1_len++;
+          }
+      }
+
+    for(i=0; i<g2->OutEdgeCount(node2); i++)
+      { other=g2->GetOutEdge(node2, i);
+        if (!term_2[other])
+          { term_2[other]=core_len;
+            t2_len++;
+          }
+      }
+  }
+
+
+
+/*--------------------------------------------------------------
+ * void VF2UndirStateBase::GetCoreSet(c1, c2)
+ * Reads the core set of the state into the arrays c1 and c2.
+ * The i-th pair of the mapping is (c1[i], c2[i])
+ --------------------------------------------------------------*/
+template <int kind>
+void VF2UndirStateBase<kind>::GetCoreSet(node_id c1[], node_id c2[])
+  { int i,j;
+    for (i=0,j=0; i<n1; i++)
+      if (core_1[i] != NULL_NODE)
+        { c1[j]=i;
+          c2[j]=core_1[i];
+          j++;
+        }
+  }
+
+
+/*----------------------------------------------------------------
+ * Clones a VF2UndirStateBase, allocating with new the clone.
+ --------------------------------------------------------------*/
+template <int kind>
+State* VF2UndirStateBase<kind>::Clone()
+  { return new VF2UndirStateBase(*this);
+  }
+
+/*----------------------------------------------------------------
+ * Makes a copy of the state that does not share its vectors
+ * with this state, allocating it with new (see state.h)
+ --------------------------------------------------------------*/
+template <int kind>
+State* VF2UndirStateBase<kind>::Fork()
+  { VF2UndirStateBase *s=new VF2UndirStateBase(*this);
+    s->Unshare();
+    return s;
+  }
+
+/*----------------------------------------------------------------
+ * Gives the state its own copy of the shared vectors, with
+ * their current contents
+ --------------------------------------------------------------*/
+template <int kind>
+void VF2UndirStateBase<kind>::Unshare()
+  { if (*share_count==1)
+      return;
+    -- *share_count;
+    share_count=new long;
+    if (share_count==NULL)
+      error("Out of memory");
+    *share_count=1;
+
+    core_1=copy_vector(core_1, n1);
+    core_2=copy_vector(core_2, n2);
+    term_1=copy_vector(term_1, n1);
+    term_2=copy_vector(term_2, n2);
+    if (order!=NULL)
+      order=copy_vector(order, n1);
+  }
+
+/*----------------------------------------------------------------
+ * Heap memory used by the vectors shared among the states
+ * of a match (the state itself holds no vectors)
+ --------------------------------------------------------------*/
+template <int kind>
+size_t VF2UndirStateBase<kind>::SharedMemoryUsage()
+  { return 2*(n1+n2)*sizeof(node_id) + sizeof(long) +
+           (order!=NULL? n1*sizeof(node_id): 0);
+  }
+
+/*----------------------------------------------------------------
+ * Estimates the peak heap memory used by the states of a match
+ * between graphs with n1 and n2 nodes: the shared vectors
+ * (including the node order), and a single state, with the
+ * data saved by PushPair for up to n1 levels (see match.cc)
+ --------------------------------------------------------------*/
+template <int kind>
+size_t VF2UndirStateBase<kind>::PeakMemoryUsage(int n1, int n2)
+  { return 2*(n1+n2)*sizeof(node_id) + sizeof(long) +
+           n1*sizeof(node_id) + sizeof(VF2UndirStateBase) +
+           n1*sizeof(pushed_pair);
+  }
+
+/*----------------------------------------------------------------
+ * Undoes the changes to the shared vectors made by the
+ * current state. Assumes that at most one AddPair has been
+ * performed.
+ ----------------------------------------------------------------*/
+template <int kind>
+void VF2UndirStateBase<kind>::BackTrack()
+  { assert(core_len - orig_core_len <= 1);
+    assert(added_node1 != NULL_NODE);
+
+    if (orig_core_len < core_len)
+      { UndoPair(added_node1);
+        core_len=orig_core_len;
+        added_node1 = NULL_NODE;
+      }
+  }
+
+/*----------------------------------------------------------------
+ * Undoes the changes to the shared vectors made by the last
+ * pair added, (node1, core_1[node1]), at level core_len
+ ----------------------------------------------------------------*/
+template <int kind>
+void VF2UndirStateBase<kind>::UndoPair(node_id node1)
+  { int i;
+    node_id node2;
+
+    if (term_1[node1] == (node_id)core_len)
+      term_1[node1] = 0;
+    for(i=0; i<g1->OutEdgeCount(node1); i++)
+      { node_id other=g1->GetOutEdge(node1, i);
+        if (term_1[other]==(node_id)core_len)
+          term_1[other]=0;
+      }
+
+    node2 = core_1[node1];
+
+    if (term_2[node2] == (node_id)core_len)
+      term_2[node2] = 0;
+    for(i=0; i<g2->OutEdgeCount(node2); i++)
+      { node_id other=g2->GetOutEdge(node2, i);
+        if (term_2[other]==(node_id)core_len)
+          term_2[other]=0;
+      }
+
+    core_1[node1] = NULL_NODE;
+    core_2[node2] = NULL_NODE;
+  }
+
+/*----------------------------------------------------------------
+ * Adds a pair to the state itself, saving what is needed
+ * to remove it with PopPair.
+ ----------------------------------------------------------------*/
+template <int kind>
+void VF2UndirStateBase<kind>::PushPair(node_id node1, node_id node2)
+  { assert(core_len<n1);
+    if (pushed==NULL)
+      { pushed=new pushed_pair[n1];
+        if (pushed==NULL)
+          error("Out of memory");
+      }
+    pushed_pair *p=&pushed[core_len];
+    p->node1=node1;
+    p->added_node1=added_node1;
+    p->t1_len=t1_len;
+    p->t2_len=t2_len;
+    AddPair(node1, node2);
+  }
+
+/*----------------------------------------------------------------
+ * Removes the last pair added by PushPair
+ ----------------------------------------------------------------*/
+template <int kind>
+void VF2UndirStateBase<kind>::PopPair()
+  { assert(pushed!=NULL && core_len>0);
+    pushed_pair *p=&pushed[core_len-1];
+    UndoPair(p->node1);
+    core_len--;
+    added_node1=p->added_node1;
+    t1_len=p->t1_len;
+    t2_len=p->t2_len;
+  }
+
+
+/*----------------------------------------------------------------
+ * Instances of the template
+ ----------------------------------------------------------------*/
+template class VF2UndirStateBase<VF2_ISOMORPHISM>;
+template class VF2UndirStateBase<VF2_SUBGRAPH>;
+template class VF2UndirStateBase<VF2_MONOMORPHISM>;
@@ -40,6 +40,9 @@ VFState::VFState(Graph *ag1, Graph *ag2)
     n2=g2->NodeCount();
 
     core_len=0;
+    pushed=NULL;
+    log=NULL;
+    log_len=0;
     t1in_len=t1out_len=0;
     t2in_len=t2out_len=0;
 
@@ -64,7 +67,10 @@ VFState::VFState(Graph *ag1, Graph *ag2)
 
 /*----------------------------------------------------------
  * VFState::VFState(state)
- * Copy constructor. 
+ * Copy constructor. The copy has its own vectors, with their
+ * current contents, and no pairs pushed: so it is also the
+ * Fork of the state, even while the state has pairs pushed
+ * (see state.h).
  ---------------------------------------------------------*/
 VFState::VFState(const VFState &state)
   { g1=state.g1;
@@ -73,6 +79,9 @@ VFState::VFState(const VFState &state)
     n2=state.n2;
 
     core_len=state.core_len;
+    pushed=NULL;
+    log=NULL;
+    log_len=0;
     t1in_len=state.t1in_len;
     t1out_len=state.t1out_len;
     t2in_len=state.t2in_len;
@@ -102,7 +111,9 @@ VFState::VFState(const VFState &state)
  * Destructor.
  --------------------------------------------------------------*/
 VFState::~VFState() 
-  { delete [] core_1;
+  { delete [] pushed;
+    delete [] log;
+    delete [] core_1;
     delete [] core_2;
     delete [] node_flags_1;
     delete [] node_flags_2;
@@ -133,16 +144,16 @@ bool VFState::NextPair(node_id *pn1, node_id *pn2,
     else
       prev_n2++;
 
-    while (prev_n1<n1 &&
+    while (prev_n1<(node_id)n1 &&
            (node_flags_1[prev_n1] & cond1)!=cond2)
       { prev_n1++;    
         prev_n2=0;
       }
 
-    while (prev_n2<n2 &&
+    while (prev_n2<(node_id)n2 &&
                (node_flags_2[prev_n2] & cond1)!=cond2)
           prev_n2++;
-    if (prev_n1<n1 && prev_n2<n2)
+    if (prev_n1<(node_id)n1 && prev_n2<(node_id)n2)
           { *pn1=prev_n1;
             *pn2=prev_n2;
             return true;
@@ -165,25 +176,24 @@ bool VFState::NextPair(node_id *pn1, node_id *pn2,
  *   criterion is not symmetric.
  --------------------------------------------------------------*/
 bool VFState::IsFeasiblePair(node_id node1, node_id node2)
-  { assert(node1<n1);
-    assert(node2<n2);
+  { assert(node1<(node_id)n1);
+    assert(node2<(node_id)n2);
     assert((node_flags_1[node1] & ST_CORE)==0);
     assert((node_flags_2[node2] & ST_CORE)==0);
 
-    if (!g1->CompatibleNode(g1->GetNodeAttr(node1), g2->GetNodeAttr(node2)))
+    if (!g1->CompatibleNodes(node1, g2, node2))
       return false;
 
-    int i, other1, other2, flags;
-    void *attr1;
+    int i, flags;
+    node_id other1, other2;
     int termout1=0, termout2=0, termin1=0, termin2=0, new1=0, new2=0;
 
     // Check the 'out' edges of node1
     for(i=0; i<g1->OutEdgeCount(node1); i++)
-      { other1=g1->GetOutEdge(node1, i, &attr1);
+      { other1=g1->GetOutEdge(node1, i);
         if ((flags=node_flags_1[other1]) & ST_CORE)
           { other2=core_1[other1];
-            if (!g2->HasEdge(node2, other2) ||
-                !g1->CompatibleEdge(attr1, g2->GetEdgeAttr(node2, other2)))
+            if (!g1->CompatibleOutEdge(node1, i, g2, node2, other2))
               return false;
           }
         else 
@@ -198,11 +208,10 @@ bool VFState::IsFeasiblePair(node_id node1, node_id node2)
 
     // Check the 'in' edges of node1
     for(i=0; i<g1->InEdgeCount(node1); i++)
-      { other1=g1->GetInEdge(node1, i, &attr1);
+      { other1=g1->GetInEdge(node1, i);
         if ((flags=node_flags_1[other1]) & ST_CORE)
           { other2=core_1[other1];
-            if (!g2->HasEdge(other2, node2) ||
-                !g1->CompatibleEdge(attr1, g2->GetEdgeAttr(other2, node2)))
+            if (!g1->CompatibleInEdge(node1, i, g2, other2, node2))
               return false;
           }
         else 
@@ -263,8 +272,8 @@ bool VFState::IsFeasiblePair(node_id node1, node_id node2)
  * Precondition: the pair must be feasible
  -------------------------------------------------------------*/
 void VFState::AddPair(node_id node1, node_id node2)
-  { assert(node1<n1);
-    assert(node2<n2);
+  { assert(node1<(node_id)n1);
+    assert(node2<(node_id)n2);
     assert(core_len<n1);
     assert(core_len<n2);
     int flags;
@@ -289,7 +298,8 @@ void VFState::AddPair(node_id node1, node_id node2)
 
     core_len++;
 
-    int i, other;
+    int i;
+    node_id other;
     for(i=0; i<g1->InEdgeCount(node1); i++)
       { other=g1->GetInEdge(node1, i);
         if (!(node_flags_1[other] & (ST_CORE | ST_TERM_IN)))
@@ -364,3 +374,98 @@ void VFState::GetCoreSet(node_id c1[], node_id c2[])
 State* VFState::Clone()
   { return new VFState(*this);
   }
+
+/*----------------------------------------------------------------
+ * Heap memory used by the state: each state has its own copy
+ * of the core and flag vectors, and the vectors of PushPair
+ * once it has been used
+ --------------------------------------------------------------*/
+size_t VFState::MemoryUsage()
+  { size_t size=sizeof(VFState) + (n1+n2)*(sizeof(node_id)+sizeof(byte));
+    if (pushed!=NULL)
+      size+=n1*sizeof(pushed_pair) + 3*(n1+n2)*sizeof(flag_change);
+    return size;
+  }
+
+/*----------------------------------------------------------------
+ * Estimates the peak heap memory used by the states of a match
+ * between graphs with n1 and n2 nodes: the search uses a single
+ * state, with PushPair (see match.cc)
+ --------------------------------------------------------------*/
+size_t VFState::PeakMemoryUsage(int n1, int n2)
+  { return sizeof(VFState) + (n1+n2)*(sizeof(node_id)+sizeof(byte)) +
+           n1*sizeof(pushed_pair) + 3*(n1+n2)*sizeof(flag_change);
+  }
+
+/*----------------------------------------------------------------
+ * Saves in the log the flags of node, and of its neighbors in g,
+ * that are going to be changed by AddPair. A neighbor gets both
+ * the terminal flags at once, so each node is saved at most
+ * three times along a path (twice as a neighbor, once as a
+ * core node)
+ --------------------------------------------------------------*/
+void VFState::LogFlags(Graph *g, byte *flags, node_id node)
+  { const int TERM=ST_TERM_IN | ST_TERM_OUT;
+    int i;
+    node_id other;
+    log[log_len].flag=&flags[node];
+    log[log_len++].old=flags[node];
+    for(i=0; i<g->InEdgeCount(node); i++)
+      { other=g->GetInEdge(node, i);
+        if (!(flags[other] & ST_CORE) && (flags[other] & TERM)!=TERM)
+          { log[log_len].flag=&flags[other];
+            log[log_len++].old=flags[other];
+          }
+      }
+    for(i=0; i<g->OutEdgeCount(node); i++)
+      { other=g->GetOutEdge(node, i);
+        if (!(flags[other] & ST_CORE) && (flags[other] & TERM)!=TERM)
+          { log[log_len].flag=&flags[other];
+            log[log_len++].old=flags[other];
+          }
+      }
+  }
+
+/*----------------------------------------------------------------
+ * Adds a pair to the state itself, saving what is needed
+ * to remove it with PopPair.
+ ----------------------------------------------------------------*/
+void VFState::PushPair(node_id node1, node_id node2)
+  { assert(core_len<n1);
+    if (pushed==NULL)
+      { pushed=new pushed_pair[n1];
+        log=new flag_change[3*(n1+n2)];
+        if (pushed==NULL || log==NULL)
+          error("Out of memory");
+      }
+    pushed_pair *p=&pushed[core_len];
+    p->node1=node1;
+    p->node2=node2;
+    p->t1in_len=t1in_len;
+    p->t1out_len=t1out_len;
+    p->t2in_len=t2in_len;
+    p->t2out_len=t2out_len;
+    p->log_len=log_len;
+    LogFlags(g1, node_flags_1, node1);
+    LogFlags(g2, node_flags_2, node2);
+    AddPair(node1, node2);
+  }
+
+/*----------------------------------------------------------------
+ * Removes the last pair added by PushPair
+ ----------------------------------------------------------------*/
+void VFState::PopPair()
+  { assert(pushed!=NULL && core_len>0);
+    pushed_pair *p=&pushed[--core_len];
+    while (log_len>p->log_len)
+      { log_len--;
+        *log[log_len].flag=log[log_len].old;
+      }
+    core_1[p->node1]=NULL_NODE;
+    core_2[p->node2]=NULL_NODE;
+    t1in_len=p->t1in_len;
+    t1out_len=p->t1out_len;
+    t2in_len=p->t2in_len;
+    t2out_len=p->t2out_len;
+  }
+
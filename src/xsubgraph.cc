@@ -9,6 +9,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 
 #include "argraph.h"
 #include "argedit.h"
@@ -70,7 +71,7 @@ Graph* ExtractSubgraph(Graph *g, int nodes, bool connected)
         
 	do {
 	  while (map[id]!=NULL_NODE) 
-	    { if (++id == n)
+	    { if (++id == (node_id)n)
 	        id=0;
               if (id==id0)
 	        { if (i==0 || !connected)
@@ -92,7 +93,7 @@ Graph* ExtractSubgraph(Graph *g, int nodes, bool connected)
 		    found=true;
 		}
 	      if (!found)
-	        { if (++id == n)
+	        { if (++id == (node_id)n)
 	            id=0;
                   if (id==id0)
 	            FAIL("Cannot extract a connected subgraph");
@@ -124,11 +125,256 @@ Graph* ExtractSubgraph(Graph *g, int nodes, bool connected)
 
     Graph *sub=new Graph(&ed);
 
+    free(map);
     return sub;
   }
 
 
 
+/*----------------------------------------------------------------
+ * methods of the class SubgraphView
+ ---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Constructor. Builds the subgraph of g induced by the 'count'
+ * nodes in 'nodes', which must be allocated with new[] and
+ * becomes owned by the view; map[i] must be the position in
+ * 'nodes' of node i of g, or NULL_NODE.
+ * The 'out' edges are first collected unsorted; the 'in' edges
+ * obtained from them by BuildInEdges are sorted, and so are
+ * the 'out' edges obtained by transposing them back.
+ * The view of an undirected graph is undirected.
+ ---------------------------------------------------------------*/
+SubgraphView::SubgraphView(Graph *g, node_id *nodes, int count,
+                           node_id *map)
+  { parent=nodes;
+    n=count;
+
+    int i, j, k;
+    offset_type edges=0;
+    for(i=0; i<n; i++)
+      { k=g->OutEdgeCount(nodes[i]);
+        for(j=0; j<k; j++)
+          if (map[g->GetOutEdge(nodes[i], j)]!=NULL_NODE)
+            edges++;
+      }
+
+    AllocStorage(edges);
+
+    offset_type pos=0;
+    for(i=0; i<n; i++)
+      { attr[i]=g->GetNodeAttr(nodes[i]);
+        out_start[i]=pos;
+        k=g->OutEdgeCount(nodes[i]);
+        for(j=0; j<k; j++)
+          { void *eattr;
+            node_id other=map[g->GetOutEdge(nodes[i], j, &eattr)];
+            if (other!=NULL_NODE)
+              { out[pos]=other;
+                out_attr[pos++]=eattr;
+              }
+          }
+      }
+    out_start[n]=pos;
+    out_end=out_start+1;
+    in_end=in_start+1;
+    edge_count=edge_slots=edges;
+
+    BuildInEdges();
+    SortOutEdges();
+    if (g->IsUndirected())
+      MakeUndirected();
+    BuildHubTables();
+
+    if (g->HasIntNodeLabels() || g->HasIntEdgeLabels())
+      UseIntLabels(g->HasIntNodeLabels(), g->HasIntEdgeLabels());
+    if (g->HasSignatures())
+      UseSignatures();
+  }
+
+/*----------------------------------------------------------------
+ * Destructor. The attributes belong to the original graph.
+ ---------------------------------------------------------------*/
+SubgraphView::~SubgraphView()
+  { delete[] parent;
+  }
+
+/*----------------------------------------------------------------
+ * Heap memory used by the view; the attributes, shared with
+ * the original graph, are not counted
+ ---------------------------------------------------------------*/
+size_t SubgraphView::MemoryUsage()
+  { return ARGraph_impl::MemoryUsage() +
+           sizeof(SubgraphView)-sizeof(ARGraph_impl) +
+           (n+1)*sizeof(node_id);
+  }
+
+/*----------------------------------------------------------------
+ * Rebuilds the 'out' vectors from the (sorted) 'in' vectors,
+ * so that each 'out' list is sorted by destination
+ ---------------------------------------------------------------*/
+void SubgraphView::SortOutEdges()
+  { offset_type *pos=new offset_type[n+1];
+    if (pos==NULL)
+      OUT_OF_MEMORY();
+    memcpy(pos, out_start, (n+1)*sizeof(offset_type));
+
+    int j;
+    offset_type p, q;
+    for(j=0; j<n; j++)
+      for(p=in_start[j]; p<in_start[j+1]; p++)
+        { q=pos[in[p]]++;
+          out[q]=j;
+          out_attr[q]=in_attr[p];
+        }
+    delete[] pos;
+  }
+
+
+
+/*----------------------------------------------------------------
+ * methods of the class SubgraphExtractor
+ ---------------------------------------------------------------*/
+
+/*----------------------------------------------------------------
+ * Constructor. Allocates the vectors used by all the extractions
+ ---------------------------------------------------------------*/
+SubgraphExtractor::SubgraphExtractor(Graph *g)
+  { assert(g!=NULL);
+    this->g=g;
+    int i, n=g->NodeCount();
+    map=new node_id[n+1];
+    mark=new bool[n+1];
+    frontier=new node_id[n+1];
+    if (map==NULL || mark==NULL || frontier==NULL)
+      OUT_OF_MEMORY();
+    for(i=0; i<n; i++)
+      { map[i]=NULL_NODE;
+        mark[i]=false;
+      }
+  }
+
+SubgraphExtractor::~SubgraphExtractor()
+  { delete[] map;
+    delete[] mark;
+    delete[] frontier;
+  }
+
+/*----------------------------------------------------------------
+ * Extracts the subgraph induced by the 'count' nodes of
+ * the vector 'nodes'; node i of the subgraph is nodes[i].
+ ---------------------------------------------------------------*/
+SubgraphView *SubgraphExtractor::Extract(node_id *nodes, int count)
+  { assert(count>=0);
+    assert(count<=g->NodeCount());
+    node_id *copy=new node_id[count+1];
+    if (copy==NULL)
+      OUT_OF_MEMORY();
+
+    int i;
+    for(i=0; i<count; i++)
+      { node_id id=nodes[i];
+        if (id>=(node_id)g->NodeCount() || map[id]!=NULL_NODE)
+          { int j;
+            for(j=0; j<i; j++)
+              map[copy[j]]=NULL_NODE;
+            error("Bad param in SubgraphExtractor::Extract");
+          }
+        map[id]=i;
+        copy[i]=id;
+      }
+    return Build(copy, count);
+  }
+
+/*----------------------------------------------------------------
+ * Extracts a random subgraph with the given number of nodes,
+ * which is connected if 'connected' is true.
+ * A connected subgraph is grown from a random node, adding
+ * each time a random node among the neighbors of the nodes
+ * already chosen (ignoring the direction of the edges).
+ *
+ * IMPORTANT
+ *   You have to init the random seed by calling srand() before
+ *   invoking this method.
+ ---------------------------------------------------------------*/
+SubgraphView *SubgraphExtractor::ExtractRandom(int nodes, bool connected)
+  { int n=g->NodeCount();
+    assert(nodes>=0);
+    assert(nodes<=n);
+
+    node_id *chosen=new node_id[nodes+1];
+    if (chosen==NULL)
+      OUT_OF_MEMORY();
+
+    int i, j, count=0, front=0;
+    while (count<nodes)
+      { node_id id;
+        if (!connected || count==0)
+          { id=irand(0, n);
+            while (map[id]!=NULL_NODE)
+              if (++id == (node_id)n)
+                id=0;
+          }
+        else
+          { if (front==0)
+              { for(i=0; i<count; i++)
+                  map[chosen[i]]=NULL_NODE;
+                FAIL("Cannot extract a connected subgraph");
+              }
+            j=irand(0, front);
+            id=frontier[j];
+            frontier[j]=frontier[--front];
+          }
+
+        map[id]=count;
+        chosen[count++]=id;
+        if (!connected)
+          continue;
+
+        // Put the new neighbors in the frontier
+        for(j=0; j<g->OutEdgeCount(id); j++)
+          { node_id other=g->GetOutEdge(id, j);
+            if (map[other]==NULL_NODE && !mark[other])
+              { mark[other]=true;
+                frontier[front++]=other;
+              }
+          }
+        for(j=0; j<g->InEdgeCount(id); j++)
+          { node_id other=g->GetInEdge(id, j);
+            if (map[other]==NULL_NODE && !mark[other])
+              { mark[other]=true;
+                frontier[front++]=other;
+              }
+          }
+      }
+
+    // Reset the marks
+    if (connected)
+      { for(i=0; i<count; i++)
+          mark[chosen[i]]=false;
+        for(i=0; i<front; i++)
+          mark[frontier[i]]=false;
+      }
+
+    return Build(chosen, count);
+  }
+
+/*----------------------------------------------------------------
+ * Builds the view of the chosen nodes, and resets their entries
+ * in map
+ ---------------------------------------------------------------*/
+SubgraphView *SubgraphExtractor::Build(node_id *nodes, int count)
+  { SubgraphView *view=new SubgraphView(g, nodes, count, map);
+    if (view==NULL)
+      OUT_OF_MEMORY();
+    int i;
+    for(i=0; i<count; i++)
+      map[nodes[i]]=NULL_NODE;
+    return view;
+  }
+
+
+
 /*---------------------------------------------------------
  *  STATIC FUNCTIONS
  --------------------------------------------------------*/